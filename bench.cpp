@@ -0,0 +1,392 @@
+// maze_bench: generates and solves mazes of several sizes with every
+// generator and solver (or the ones asked for), always from the same seeds,
+// and reports time per cell, expanded cells, peak memory and heap
+// allocations of each run as CSV or JSON. Generation and each solver are
+// measured separately; start and goal are opposite corners, as in headless
+// mode.
+#include "engine.h"
+#include "grid.h"
+#include "sink.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "tiling.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#if !defined(__linux__) && !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+// Heap statistics, kept by the replaced global operator new and delete
+// below. Every block carries its size in a header, so the live total is
+// known at any time.
+static std::atomic<long> allocationCount(0);
+static std::atomic<long long> allocatedBytes(0);
+static std::atomic<long long> liveBytes(0);
+static std::atomic<long long> peakLiveBytes(0);
+
+static const std::size_t BLOCK_HEADER = 16; // keeps blocks 16-byte aligned
+
+static void *countedAllocate(std::size_t size) {
+  void *block = std::malloc(size + BLOCK_HEADER);
+  if (block == nullptr)
+    return nullptr;
+  *static_cast<std::size_t *>(block) = size;
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  long long live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+  long long peak = peakLiveBytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !peakLiveBytes.compare_exchange_weak(peak, live,
+                                              std::memory_order_relaxed)) {
+  }
+  return static_cast<char *>(block) + BLOCK_HEADER;
+}
+
+static void countedFree(void *pointer) {
+  if (pointer == nullptr)
+    return;
+  void *block = static_cast<char *>(pointer) - BLOCK_HEADER;
+  liveBytes.fetch_sub(*static_cast<std::size_t *>(block),
+                      std::memory_order_relaxed);
+  std::free(block);
+}
+
+void *operator new(std::size_t size) {
+  void *pointer = countedAllocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAllocate(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAllocate(size);
+}
+void operator delete(void *pointer) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer) noexcept { countedFree(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+  countedFree(pointer);
+}
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+  countedFree(pointer);
+}
+
+// Function to restart the peak resident set size. Only Linux can do that;
+// elsewhere the peak covers the whole process so far.
+static void resetPeakRss() {
+#ifdef __linux__
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+#endif
+}
+
+// Function to read the peak resident set size in kilobytes (0 if unknown)
+static long peakRssKb() {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::atol(line.c_str() + 6);
+  }
+  return 0;
+#elif !defined(_WIN32)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+// What one measured call cost
+struct Measurement {
+  double millis = 0;
+  long allocations = 0;
+  long long allocatedBytes = 0;
+  long long peakHeapBytes = 0; // above what was live before the call
+  long peakRssKb = 0;
+};
+
+// Function to run fn repeat times and measure it: the fastest time, and the
+// memory figures of the first run
+template <class Fn> static Measurement measure(int repeat, Fn fn) {
+  typedef std::chrono::steady_clock Clock;
+  Measurement result;
+  for (int run = 0; run < repeat; ++run) {
+    resetPeakRss();
+    long allocationsBefore = allocationCount.load();
+    long long bytesBefore = allocatedBytes.load();
+    long long liveBefore = liveBytes.load();
+    peakLiveBytes.store(liveBefore);
+
+    Clock::time_point t0 = Clock::now();
+    fn();
+    Clock::time_point t1 = Clock::now();
+
+    double millis = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    if (run == 0) {
+      result.millis = millis;
+      result.allocations = allocationCount.load() - allocationsBefore;
+      result.allocatedBytes = allocatedBytes.load() - bytesBefore;
+      result.peakHeapBytes = peakLiveBytes.load() - liveBefore;
+      result.peakRssKb = peakRssKb();
+    } else if (millis < result.millis) {
+      result.millis = millis;
+    }
+  }
+  return result;
+}
+
+// One line of the report: a generation (solver "-") or a search
+struct BenchRow {
+  int width, height;
+  std::string generator, solver;
+  int threads = 1; // of the pool a tiled generator ran on
+  std::uint64_t seed;
+  Measurement cost;
+  bool found = false;
+  long pathLength = 0;
+  long expanded = 0;
+};
+
+static const char *GENERATOR_NAMES[] = {"dfs",      "prims",  "division",
+                                        "kruskals", "ellers", "wilsons",
+                                        "aldousbroder"};
+static const char *SOLVER_NAMES[] = {"dfs",    "bfs",     "dijkstra", "astar",
+                                     "bibfs",  "biastar", "jps",      "jpsplus",
+                                     "tree",   "bitbfs",  "pbfs"};
+
+// Function to split a comma separated list
+static std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+static double nsPerCell(const BenchRow &row) {
+  return row.cost.millis * 1e6 / (double(row.width) * row.height);
+}
+
+static void writeCsv(std::ostream &out, const std::vector<BenchRow> &rows) {
+  out << "width,height,generator,solver,threads,seed,ms,ns_per_cell,found,"
+         "path_length,expanded,allocations,allocated_bytes,peak_heap_bytes,"
+         "peak_rss_kb\n";
+  for (const BenchRow &row : rows)
+    out << row.width << ',' << row.height << ',' << row.generator << ','
+        << row.solver << ',' << row.threads << ',' << row.seed << ','
+        << row.cost.millis << ','
+        << nsPerCell(row) << ',' << row.found << ',' << row.pathLength << ','
+        << row.expanded << ',' << row.cost.allocations << ','
+        << row.cost.allocatedBytes << ',' << row.cost.peakHeapBytes << ','
+        << row.cost.peakRssKb << '\n';
+}
+
+static void writeJson(std::ostream &out, const std::vector<BenchRow> &rows) {
+  out << "[\n";
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    const BenchRow &row = rows[i];
+    out << "  {\"width\": " << row.width << ", \"height\": " << row.height
+        << ", \"generator\": \"" << row.generator << "\", \"solver\": \""
+        << row.solver << "\", \"threads\": " << row.threads
+        << ", \"seed\": " << row.seed
+        << ", \"ms\": " << row.cost.millis
+        << ", \"ns_per_cell\": " << nsPerCell(row)
+        << ", \"found\": " << (row.found ? "true" : "false")
+        << ", \"path_length\": " << row.pathLength
+        << ", \"expanded\": " << row.expanded
+        << ", \"allocations\": " << row.cost.allocations
+        << ", \"allocated_bytes\": " << row.cost.allocatedBytes
+        << ", \"peak_heap_bytes\": " << row.cost.peakHeapBytes
+        << ", \"peak_rss_kb\": " << row.cost.peakRssKb << "}"
+        << (i + 1 < rows.size() ? ",\n" : "\n");
+  }
+  out << "]\n";
+}
+
+static void printUsage(const char *program) {
+  std::cout << "Usage: " << program << " [options]\n"
+            << "  --sizes LIST          maze sizes, comma separated (default\n"
+            << "                        101,1001,10001; mazes are square)\n"
+            << "  --generators LIST     generators to run (default: all)\n"
+            << "  --solvers LIST        solvers to run (default: all; none\n"
+            << "                        to time generation only)\n"
+            << "  --tiled LIST          also time tiled generation on pools of\n"
+            << "                        these thread counts, comma separated\n"
+            << "  --seed N              seed of every maze (default 1)\n"
+            << "  --repeat N            time each run N times, keep the\n"
+            << "                        fastest (default 1)\n"
+            << "  --format csv|json     report format (default csv)\n"
+            << "  --output FILE         write the report to FILE instead of\n"
+            << "                        stdout\n"
+            << "Progress goes to stderr." << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<int> sizes;
+  std::vector<std::string> generatorNames(
+      GENERATOR_NAMES, GENERATOR_NAMES + sizeof(GENERATOR_NAMES) /
+                                             sizeof(GENERATOR_NAMES[0]));
+  std::vector<std::string> solverNames(
+      SOLVER_NAMES, SOLVER_NAMES + sizeof(SOLVER_NAMES) / sizeof(SOLVER_NAMES[0]));
+  std::vector<int> tiledThreads;
+  std::uint64_t seed = 1;
+  int repeat = 1;
+  std::string format = "csv";
+  std::string outputFile;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(arg, "--sizes") == 0 && hasValue) {
+      for (const std::string &size : splitList(argv[++i]))
+        sizes.push_back(std::atoi(size.c_str()));
+    } else if (std::strcmp(arg, "--generators") == 0 && hasValue) {
+      generatorNames = splitList(argv[++i]);
+    } else if (std::strcmp(arg, "--solvers") == 0 && hasValue) {
+      solverNames = splitList(argv[++i]);
+      if (solverNames.size() == 1 && solverNames[0] == "none")
+        solverNames.clear();
+    } else if (std::strcmp(arg, "--tiled") == 0 && hasValue) {
+      for (const std::string &threads : splitList(argv[++i]))
+        tiledThreads.push_back(std::max(1, std::atoi(threads.c_str())));
+    } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--repeat") == 0 && hasValue) {
+      repeat = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--format") == 0 && hasValue) {
+      format = argv[++i];
+    } else if (std::strcmp(arg, "--output") == 0 && hasValue) {
+      outputFile = argv[++i];
+    } else {
+      printUsage(argv[0]);
+      return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+  if (sizes.empty()) {
+    sizes.push_back(101);
+    sizes.push_back(1001);
+    sizes.push_back(10001);
+  }
+
+  // Check every name before the first run, which may take minutes
+  std::vector<GeneratorType> generators(generatorNames.size());
+  std::vector<SolverType> solvers(solverNames.size());
+  for (std::size_t i = 0; i < generatorNames.size(); ++i) {
+    if (!parseGeneratorType(generatorNames[i], generators[i])) {
+      std::cerr << "Unknown generator: " << generatorNames[i] << std::endl;
+      return 1;
+    }
+  }
+  for (std::size_t i = 0; i < solverNames.size(); ++i) {
+    if (!parseSolverType(solverNames[i], solvers[i])) {
+      std::cerr << "Unknown solver: " << solverNames[i] << std::endl;
+      return 1;
+    }
+  }
+  for (int size : sizes) {
+    if (size < 5) {
+      std::cerr << "Dimensions too small: " << size << std::endl;
+      return 1;
+    }
+    if (!Grid::fits(size | 1, size | 1)) {
+      std::cerr << "Dimensions too large: " << size << std::endl;
+      return 1;
+    }
+  }
+  if (format != "csv" && format != "json") {
+    std::cerr << "Unknown format: " << format << std::endl;
+    return 1;
+  }
+  repeat = std::max(1, repeat);
+
+  std::vector<BenchRow> rows;
+  for (int size : sizes) {
+    for (std::size_t g = 0; g < generators.size(); ++g) {
+      Grid maze;
+      BenchRow generation;
+      generation.generator = generatorNames[g];
+      generation.solver = "-";
+      generation.seed = seed;
+      generation.cost = measure(repeat, [&]() {
+        maze = Grid();
+        maze = generateMazeWith(generators[g], size, size, nullSink(), seed);
+      });
+      generation.width = maze.width();
+      generation.height = maze.height();
+      rows.push_back(generation);
+      std::cerr << generation.generator << ' ' << maze.width() << 'x'
+                << maze.height() << " generate_ms=" << generation.cost.millis
+                << std::endl;
+
+      // The same generator on tiles carved concurrently (see tiling.h); the
+      // mazes differ from the whole one, so they are not solved
+      for (int threads : tiledThreads) {
+        ThreadPool pool(threads);
+        BenchRow row = generation;
+        row.generator = generatorNames[g] + "-tiled";
+        row.threads = pool.size();
+        row.cost = measure(repeat, [&]() {
+          generateTiledMaze(size, size, carverFor(generators[g]), pool, seed);
+        });
+        rows.push_back(row);
+        std::cerr << row.generator << ' ' << row.width << 'x' << row.height
+                  << " threads=" << row.threads
+                  << " generate_ms=" << row.cost.millis << " speedup="
+                  << generation.cost.millis / row.cost.millis << std::endl;
+      }
+
+      for (std::size_t s = 0; s < solvers.size(); ++s) {
+        BenchRow search = generation;
+        search.solver = solverNames[s];
+        SearchResult result;
+        search.cost = measure(repeat, [&]() {
+          result = SearchResult();
+          result = solveMazeWith(solvers[s], maze, 1, 1, maze.width() - 2,
+                                 maze.height() - 2);
+        });
+        search.found = result.found;
+        search.pathLength = result.found ? result.path.size() - 1 : 0;
+        search.expanded = result.expanded;
+        rows.push_back(search);
+        std::cerr << "  " << search.solver << " solve_ms=" << search.cost.millis
+                  << " expanded=" << search.expanded << std::endl;
+      }
+    }
+  }
+
+  std::ofstream file;
+  if (!outputFile.empty()) {
+    file.open(outputFile);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open file: " << outputFile << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = outputFile.empty() ? std::cout : file;
+  if (format == "json")
+    writeJson(out, rows);
+  else
+    writeCsv(out, rows);
+  return out ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+#include "bitbfs.h"
+#include "definitions.h"
+#include "searchstate.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MAZE_BITBFS_X86 1
+#include <immintrin.h>
+#endif
+
+// Bit b of a block word is the cell at column b % 8, row b / 8 of the block
+static const std::uint64_t COLUMN_0 = 0x0101010101010101ULL;
+static const std::uint64_t COLUMN_7 = COLUMN_0 << 7;
+
+BitBlocks::BitBlocks(const BitMaze &maze) {
+  const Bitmap &bits = maze.wallBits();
+  int rows = maze.height() + 2;
+  rowBlocks_ = bits.stride() / 8;
+  count_ = ((rows + 7) / 8 + 2) * rowBlocks_;
+  walls_.assign(count_, ~std::uint64_t(0));
+  // Byte k of a row word holds the eight columns of block k of that word,
+  // lowest column in the lowest bit, which is exactly one block row
+  const std::uint64_t *words = bits.words();
+  for (int y = 0; y < rows; ++y) {
+    const std::uint64_t *row = words + std::size_t(y) * bits.rowWords();
+    std::uint64_t *blocks = &walls_[(y / 8 + 1) * rowBlocks_];
+    int shift = 8 * (y % 8);
+    for (int b = 0; b < rowBlocks_; ++b) {
+      std::uint64_t byte = (row[b / 8] >> (8 * (b % 8))) & 0xFF;
+      blocks[b] =
+          (blocks[b] & ~(std::uint64_t(0xFF) << shift)) | (byte << shift);
+    }
+  }
+}
+
+BitBlocks::BitBlocks(const Grid &maze) : BitBlocks(toBitMaze(maze)) {}
+
+// Buffers of one search, all in block layout
+struct Layer {
+  const std::uint64_t *walls;
+  const std::uint64_t *frontier;
+  std::uint64_t *next;
+  std::uint64_t *visited;
+  std::uint64_t *phase0, *phase1; // layer number modulo 3, low and high bit
+  std::uint64_t mask0, mask1;     // all ones where the current layer sets them
+  int rowBlocks;
+};
+
+// Function to return the cells of block i next to a frontier cell: the
+// block's own frontier shifted one column or row, plus the edge column or row
+// of the neighbouring block carried in. Walls mask off the rest.
+static inline std::uint64_t spread(const Layer &layer, int i) {
+  const std::uint64_t *f = layer.frontier;
+  std::uint64_t cur = f[i];
+  return ((cur << 1) & ~COLUMN_0) | ((f[i - 1] & COLUMN_7) >> 7) |
+         ((cur >> 1) & ~COLUMN_7) | ((f[i + 1] & COLUMN_0) << 7) |
+         (cur << 8) | (f[i - layer.rowBlocks] >> 56) | (cur >> 8) |
+         (f[i + layer.rowBlocks] << 56);
+}
+
+// Function to compute block i of the next layer and add it to visited and
+// the phase planes
+static inline std::uint64_t expandBlock(const Layer &layer, int i) {
+  std::uint64_t n = spread(layer, i) & ~layer.walls[i] & ~layer.visited[i];
+  layer.next[i] = n;
+  if (n) {
+    layer.visited[i] |= n;
+    layer.phase0[i] |= n & layer.mask0;
+    layer.phase1[i] |= n & layer.mask1;
+  }
+  return n;
+}
+
+// Function to compute the next layer for blocks [begin, end) and append the
+// index of every non-empty block written to active. The SIMD versions do the
+// same two or four blocks at a time and finish the tail here.
+static void expandScalar(const Layer &layer, int begin, int end,
+                         std::vector<int> &active) {
+  for (int i = begin; i < end; ++i) {
+    if (expandBlock(layer, i))
+      active.push_back(i);
+  }
+}
+
+#ifdef MAZE_BITBFS_X86
+static void expandSSE2(const Layer &layer, int begin, int end,
+                       std::vector<int> &active) {
+#define LOAD(p) _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+#define STORE(p, v) _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v)
+  const std::uint64_t *f = layer.frontier;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i column0 = _mm_set1_epi64x(COLUMN_0);
+  const __m128i column7 = _mm_set1_epi64x(COLUMN_7);
+  const __m128i mask0 = _mm_set1_epi64x(layer.mask0);
+  const __m128i mask1 = _mm_set1_epi64x(layer.mask1);
+  int i = begin;
+  for (; i + 2 <= end; i += 2) {
+    __m128i cur = LOAD(f + i);
+    __m128i east = _mm_or_si128(
+        _mm_andnot_si128(column0, _mm_slli_epi64(cur, 1)),
+        _mm_srli_epi64(_mm_and_si128(LOAD(f + i - 1), column7), 7));
+    __m128i west = _mm_or_si128(
+        _mm_andnot_si128(column7, _mm_srli_epi64(cur, 1)),
+        _mm_slli_epi64(_mm_and_si128(LOAD(f + i + 1), column0), 7));
+    __m128i south = _mm_or_si128(
+        _mm_slli_epi64(cur, 8),
+        _mm_srli_epi64(LOAD(f + i - layer.rowBlocks), 56));
+    __m128i north = _mm_or_si128(
+        _mm_srli_epi64(cur, 8),
+        _mm_slli_epi64(LOAD(f + i + layer.rowBlocks), 56));
+    __m128i s =
+        _mm_or_si128(_mm_or_si128(east, west), _mm_or_si128(south, north));
+    __m128i visited = LOAD(layer.visited + i);
+    __m128i n = _mm_andnot_si128(visited,
+                                 _mm_andnot_si128(LOAD(layer.walls + i), s));
+    STORE(layer.next + i, n);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(n, zero)) != 0xFFFF) {
+      STORE(layer.visited + i, _mm_or_si128(visited, n));
+      STORE(layer.phase0 + i,
+            _mm_or_si128(LOAD(layer.phase0 + i), _mm_and_si128(n, mask0)));
+      STORE(layer.phase1 + i,
+            _mm_or_si128(LOAD(layer.phase1 + i), _mm_and_si128(n, mask1)));
+      for (int j = i; j < i + 2; ++j) {
+        if (layer.next[j])
+          active.push_back(j);
+      }
+    }
+  }
+#undef LOAD
+#undef STORE
+  expandScalar(layer, i, end, active);
+}
+
+__attribute__((target("avx2"))) static void
+expandAVX2(const Layer &layer, int begin, int end, std::vector<int> &active) {
+#define LOAD(p) _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+#define STORE(p, v) _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v)
+  const std::uint64_t *f = layer.frontier;
+  const __m256i column0 = _mm256_set1_epi64x(COLUMN_0);
+  const __m256i column7 = _mm256_set1_epi64x(COLUMN_7);
+  const __m256i mask0 = _mm256_set1_epi64x(layer.mask0);
+  const __m256i mask1 = _mm256_set1_epi64x(layer.mask1);
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256i cur = LOAD(f + i);
+    __m256i east = _mm256_or_si256(
+        _mm256_andnot_si256(column0, _mm256_slli_epi64(cur, 1)),
+        _mm256_srli_epi64(_mm256_and_si256(LOAD(f + i - 1), column7), 7));
+    __m256i west = _mm256_or_si256(
+        _mm256_andnot_si256(column7, _mm256_srli_epi64(cur, 1)),
+        _mm256_slli_epi64(_mm256_and_si256(LOAD(f + i + 1), column0), 7));
+    __m256i south = _mm256_or_si256(
+        _mm256_slli_epi64(cur, 8),
+        _mm256_srli_epi64(LOAD(f + i - layer.rowBlocks), 56));
+    __m256i north = _mm256_or_si256(
+        _mm256_srli_epi64(cur, 8),
+        _mm256_slli_epi64(LOAD(f + i + layer.rowBlocks), 56));
+    __m256i s = _mm256_or_si256(_mm256_or_si256(east, west),
+                                _mm256_or_si256(south, north));
+    __m256i visited = LOAD(layer.visited + i);
+    __m256i n = _mm256_andnot_si256(
+        visited, _mm256_andnot_si256(LOAD(layer.walls + i), s));
+    STORE(layer.next + i, n);
+    if (!_mm256_testz_si256(n, n)) {
+      STORE(layer.visited + i, _mm256_or_si256(visited, n));
+      STORE(layer.phase0 + i, _mm256_or_si256(LOAD(layer.phase0 + i),
+                                              _mm256_and_si256(n, mask0)));
+      STORE(layer.phase1 + i, _mm256_or_si256(LOAD(layer.phase1 + i),
+                                              _mm256_and_si256(n, mask1)));
+      for (int j = i; j < i + 4; ++j) {
+        if (layer.next[j])
+          active.push_back(j);
+      }
+    }
+  }
+#undef LOAD
+#undef STORE
+  expandScalar(layer, i, end, active);
+}
+#endif
+
+SimdLevel detectSimdLevel() {
+#ifdef MAZE_BITBFS_X86
+  static const SimdLevel level =
+      __builtin_cpu_supports("avx2") ? SIMD_AVX2 : SIMD_SSE2;
+  return level;
+#else
+  return SIMD_SCALAR;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SIMD_AVX2:
+    return "avx2";
+  case SIMD_SSE2:
+    return "sse2";
+  case SIMD_SCALAR:
+  default:
+    return "scalar";
+  }
+}
+
+template <class Maze>
+static SearchResult searchBits(const Maze &maze, const BitBlocks &blocks,
+                               int startX, int startY, int goalX, int goalY,
+                               MazeSink &sink, SimdLevel level,
+                               BitSearchState &state) {
+  SearchResult result;
+  sink.reset(maze);
+  if (maze(startX, startY) == WALL || maze(goalX, goalY) == WALL)
+    return result;
+
+  void (*expand)(const Layer &, int, int, std::vector<int> &) = expandScalar;
+#ifdef MAZE_BITBFS_X86
+  if (level >= SIMD_AVX2 && detectSimdLevel() >= SIMD_AVX2)
+    expand = expandAVX2;
+  else if (level >= SIMD_SSE2)
+    expand = expandSSE2;
+#endif
+
+  int rowBlocks = blocks.rowBlocks();
+  int count = blocks.count();
+  state.begin(count);
+  std::vector<std::uint64_t> &frontier = state.frontier;
+  std::vector<std::uint64_t> &next = state.next;
+  std::vector<std::uint64_t> &visited = state.visited;
+  // Cells are addressed in the padded space, one in from the border
+  int startBlock = blocks.block(startX + 1, startY + 1);
+  int goalBlock = blocks.block(goalX + 1, goalY + 1);
+  std::uint64_t goalBit = std::uint64_t(1)
+                          << BitBlocks::bit(goalX + 1, goalY + 1);
+  frontier[startBlock] = std::uint64_t(1)
+                         << BitBlocks::bit(startX + 1, startY + 1);
+  visited[startBlock] = frontier[startBlock];
+  state.touch(startBlock);
+  result.expanded = 1;
+
+  Layer layer;
+  layer.walls = blocks.walls();
+  layer.rowBlocks = rowBlocks;
+  layer.visited = visited.data();
+  layer.phase0 = state.phase0.data();
+  layer.phase1 = state.phase1.data();
+
+  // active lists the non-empty frontier blocks and next is all zero between
+  // layers. A small frontier is expanded block by block around its active
+  // blocks (seen keeps each block to one visit per layer); once the active
+  // blocks are dense within their span, the whole span is swept with the
+  // vector kernel instead. Every block a layer reaches is in nextActive, so
+  // those are the only ones the next query has to clear.
+  std::vector<int> &active = state.active;
+  std::vector<int> &nextActive = state.nextActive;
+  std::vector<unsigned> &seen = state.seen;
+  active.assign(1, startBlock);
+  int distance = 0;
+  bool found = (frontier[goalBlock] & goalBit) != 0;
+  while (!found) {
+    ++distance;
+    state.nextLayer();
+    layer.frontier = frontier.data();
+    layer.next = next.data();
+    layer.mask0 = distance % 3 == 1 ? ~std::uint64_t(0) : 0;
+    layer.mask1 = distance % 3 == 2 ? ~std::uint64_t(0) : 0;
+    nextActive.clear();
+
+    int first = INT_MAX;
+    int last = -1;
+    for (int b : active) {
+      first = std::min(first, b);
+      last = std::max(last, b);
+    }
+    // The guard rows are all wall, so no layer ever needs them
+    int begin = std::max(first - rowBlocks, rowBlocks);
+    int end = std::min(last + rowBlocks + 1, count - rowBlocks);
+    if (4 * active.size() < static_cast<size_t>(end - begin)) {
+      const int around[5] = {-rowBlocks, -1, 0, 1, rowBlocks};
+      for (int b : active) {
+        for (int k = 0; k < 5; ++k) {
+          int i = b + around[k];
+          if (i < rowBlocks || i >= count - rowBlocks || seen[i] == state.layer)
+            continue;
+          seen[i] = state.layer;
+          if (expandBlock(layer, i))
+            nextActive.push_back(i);
+        }
+      }
+    } else {
+      expand(layer, begin, end, nextActive);
+    }
+
+    for (int b : nextActive) {
+      state.touch(b);
+      result.expanded += __builtin_popcountll(next[b]);
+    }
+    for (int b : active)
+      frontier[b] = 0;
+    frontier.swap(next);
+    active.swap(nextActive);
+    if (active.empty())
+      break; // every reachable cell is visited
+    found = (frontier[goalBlock] & goalBit) != 0;
+  }
+  // Leave frontier all zero for the next query
+  for (int b : active)
+    frontier[b] = 0;
+  if (!found)
+    return result;
+
+  // Walk back one layer at a time: among the neighbours only those one layer
+  // closer to the start carry the residue (d - 1) mod 3
+  auto test = [&](const std::vector<std::uint64_t> &bits, int px, int py) {
+    return int(bits[blocks.block(px, py)] >> BitBlocks::bit(px, py)) & 1;
+  };
+  const int dx[4] = {1, -1, 0, 0};
+  const int dy[4] = {0, 0, 1, -1};
+  int px = goalX + 1;
+  int py = goalY + 1;
+  result.path.push_back(std::make_pair(goalX, goalY));
+  for (int d = distance; d > 0; --d) {
+    int want = (d - 1) % 3;
+    for (int k = 0; k < 4; ++k) {
+      int nx = px + dx[k];
+      int ny = py + dy[k];
+      if (test(visited, nx, ny) &&
+          test(state.phase0, nx, ny) + 2 * test(state.phase1, nx, ny) ==
+              want) {
+        px = nx;
+        py = ny;
+        break;
+      }
+    }
+    result.path.push_back(std::make_pair(px - 1, py - 1));
+    if (d > 1) {
+      sink.cell(px - 1, py - 1, PATH);
+      sink.step();
+    }
+  }
+  std::reverse(result.path.begin(), result.path.end());
+  result.found = true;
+  return result;
+}
+
+SearchResult findPathBitBFS(const BitMaze &maze, int startX, int startY,
+                            int goalX, int goalY, MazeSink &sink,
+                            SimdLevel level) {
+  return searchBits(maze, BitBlocks(maze), startX, startY, goalX, goalY, sink,
+                    level, threadSearchState().bits);
+}
+SearchResult findPathBitBFS(const Grid &maze, int startX, int startY,
+                            int goalX, int goalY, MazeSink &sink,
+                            SimdLevel level) {
+  return searchBits(maze, BitBlocks(maze), startX, startY, goalX, goalY, sink,
+                    level, threadSearchState().bits);
+}
+SearchResult findPathBitBFS(const BitMaze &maze, const BitBlocks &blocks,
+                            int startX, int startY, int goalX, int goalY,
+                            MazeSink &sink, SimdLevel level) {
+  return searchBits(maze, blocks, startX, startY, goalX, goalY, sink, level,
+                    threadSearchState().bits);
+}
+SearchResult findPathBitBFS(const Grid &maze, const BitBlocks &blocks,
+                            int startX, int startY, int goalX, int goalY,
+                            MazeSink &sink, SimdLevel level) {
+  return searchBits(maze, blocks, startX, startY, goalX, goalY, sink, level,
+                    threadSearchState().bits);
+}
+
+SearchResult SolverContext::findPathBitBFS(const BitBlocks &blocks, int startX,
+                                           int startY, int goalX, int goalY,
+                                           MazeSink &sink) {
+  if (grid)
+    return searchBits(*grid, blocks, startX, startY, goalX, goalY, sink,
+                      detectSimdLevel(), state->bits);
+  return searchBits(*bits, blocks, startX, startY, goalX, goalY, sink,
+                    detectSimdLevel(), state->bits);
+}
@@ -0,0 +1,78 @@
+#ifndef MAZE_BITBFS_H
+#define MAZE_BITBFS_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "sink.h"
+#include "solver.h"
+#include <cstdint>
+#include <vector>
+
+// Instruction sets the bit-parallel BFS can run on, narrowest first
+enum SimdLevel {
+  SIMD_SCALAR = 1, // one 64-bit word per step
+  SIMD_SSE2,       // two words per step
+  SIMD_AVX2        // four words (256 cells) per step
+};
+
+// Function to return the widest level the running CPU supports (checked once)
+SimdLevel detectSimdLevel();
+// Function to name a level for reports (scalar, sse2, avx2)
+const char *simdLevelName(SimdLevel level);
+
+// The maze's padded cell space (border included, see Bitmap) cut into 8x8
+// blocks of wall bits, the layout the bit-parallel BFS works in, with one row
+// of blocks above and below for its kernels to read past the edges. Building
+// it touches every cell, so for many searches on one maze build it once and
+// pass it to each of them (solveBatch does). Walls, padding and the guard
+// rows are all set.
+class BitBlocks {
+public:
+  explicit BitBlocks(const BitMaze &maze);
+  explicit BitBlocks(const Grid &maze);
+
+  int rowBlocks() const { return rowBlocks_; } // blocks per row, stride / 8
+  int count() const { return count_; }         // blocks, guard rows included
+  const std::uint64_t *walls() const { return walls_.data(); }
+
+  // Block word and bit of a padded cell (px, py) = (x + 1, y + 1)
+  int block(int px, int py) const {
+    return (py / 8 + 1) * rowBlocks_ + px / 8;
+  }
+  static int bit(int px, int py) { return (py % 8) * 8 + px % 8; }
+
+private:
+  int rowBlocks_, count_;
+  std::vector<std::uint64_t> walls_;
+};
+
+// Breadth-first search as bitset operations over the wall bits: every layer
+// is next = (frontier shifted E, W, S and N) & open & ~visited, computed a
+// word at a time, so a whole row segment advances per instruction. Only the
+// words between the first and last frontier word (plus one row either side)
+// are touched per layer, so open maps with wide frontiers gain the most and
+// corridor mazes with thousands of thin layers the least. Each cell keeps its
+// layer number modulo 3 in two bit planes, which is enough to walk back from
+// the goal: a neighbour one layer closer always has the previous residue.
+// The result matches findPathBFS in length; expanded counts reached cells and
+// the sink sees the final path only. Without blocks the maze is cut into
+// BitBlocks first. The layer buffers are kept per thread (or per
+// SolverContext, see findPathBitBFS there) and only the blocks a query
+// reached are cleared for the next one.
+SearchResult findPathBitBFS(const BitMaze &maze, int startX, int startY,
+                            int goalX, int goalY, MazeSink &sink = nullSink(),
+                            SimdLevel level = detectSimdLevel());
+SearchResult findPathBitBFS(const Grid &maze, int startX, int startY,
+                            int goalX, int goalY, MazeSink &sink = nullSink(),
+                            SimdLevel level = detectSimdLevel());
+// blocks must have been built from maze
+SearchResult findPathBitBFS(const BitMaze &maze, const BitBlocks &blocks,
+                            int startX, int startY, int goalX, int goalY,
+                            MazeSink &sink = nullSink(),
+                            SimdLevel level = detectSimdLevel());
+SearchResult findPathBitBFS(const Grid &maze, const BitBlocks &blocks,
+                            int startX, int startY, int goalX, int goalY,
+                            MazeSink &sink = nullSink(),
+                            SimdLevel level = detectSimdLevel());
+
+#endif // MAZE_BITBFS_H
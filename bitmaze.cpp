@@ -0,0 +1,91 @@
+#include "bitmaze.h"
+#include "definitions.h"
+#include "grid.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Bits per row of a bitmap of the given width: border included, rounded up
+// to whole words
+static long long bitStride(int width) { return (width + 65LL) / 64 * 64; }
+
+Bitmap::Bitmap(int width, int height, bool value, bool border)
+    : width_(width), height_(height),
+      stride_(static_cast<int>(bitStride(width))),
+      bits(indexedCells(bitStride(width), height) / 64,
+           border ? ~std::uint64_t(0) : 0),
+      data(bits.data()) {
+  fill(value);
+}
+
+Bitmap::Bitmap(int width, int height, std::uint64_t *data,
+               std::shared_ptr<void> owner)
+    : width_(width), height_(height),
+      stride_(static_cast<int>(bitStride(width))), data(data),
+      owner(std::move(owner)) {
+  indexedCells(bitStride(width), height);
+}
+
+bool Bitmap::fits(int width, int height) {
+  return width >= 0 && fitsIndexRange(bitStride(width), height);
+}
+
+Bitmap::Bitmap(const Bitmap &other)
+    : width_(other.width_), height_(other.height_), stride_(other.stride_),
+      bits(other.data, other.data + other.wordCount()), data(bits.data()) {}
+
+Bitmap &Bitmap::operator=(const Bitmap &other) {
+  if (this != &other) {
+    width_ = other.width_;
+    height_ = other.height_;
+    stride_ = other.stride_;
+    bits.assign(other.data, other.data + other.wordCount());
+    data = bits.data();
+    owner.reset();
+  }
+  return *this;
+}
+
+void Bitmap::fillRange(int first, int last, bool value) {
+  // Whole words in between are written directly, only the two partial words
+  // at the ends are masked
+  for (int w = first >> 6; w <= last >> 6; ++w) {
+    int lo = std::max(first, w * 64) - w * 64;
+    int hi = std::min(last, w * 64 + 63) - w * 64;
+    std::uint64_t mask =
+        (hi == 63 ? ~std::uint64_t(0) : (std::uint64_t(1) << (hi + 1)) - 1) &
+        ~((std::uint64_t(1) << lo) - 1);
+    data[w] = value ? data[w] | mask : data[w] & ~mask;
+  }
+}
+
+void Bitmap::fill(bool value) {
+  for (int y = 0; y < height_; ++y)
+    fillRange(index(0, y), index(width_ - 1, y), value);
+}
+
+void Bitmap::clear() { std::fill(data, data + wordCount(), 0); }
+
+BitMaze toBitMaze(const Grid &maze) {
+  BitMaze bits(maze.width(), maze.height(), EMPTY);
+  for (int y = 0; y < maze.height(); ++y) {
+    const char *row = maze.row(y);
+    for (int x = 0; x < maze.width(); ++x) {
+      if (row[x] == WALL)
+        bits.set(x, y, WALL);
+    }
+  }
+  return bits;
+}
+
+Grid toGrid(const BitMaze &maze) {
+  Grid grid(maze.width(), maze.height(), EMPTY);
+  for (int y = 0; y < maze.height(); ++y) {
+    char *row = grid.row(y);
+    for (int x = 0; x < maze.width(); ++x)
+      row[x] = maze(x, y);
+  }
+  return grid;
+}
@@ -0,0 +1,129 @@
+#ifndef MAZE_BITMAZE_H
+#define MAZE_BITMAZE_H
+
+#include "definitions.h"
+#include "grid.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Two-dimensional bitset laid out like Grid: one border bit around the maze
+// and rows padded to whole 64-bit words, so index(x, y) +-1 / +-stride()
+// address the four neighbours and rows can be processed a word at a time.
+// The words normally live in the bitmap itself, but can also be borrowed
+// from a mapped file (see mazefile.h); copies always own their words.
+class Bitmap {
+public:
+  Bitmap()
+      : width_(0), height_(0), stride_(64), bits(2, 0), data(bits.data()) {}
+  Bitmap(int width, int height, bool value = false, bool border = false);
+  // Bitmap over the words at data, laid out as described above; owner keeps
+  // them alive for as long as any bitmap uses them
+  Bitmap(int width, int height, std::uint64_t *data,
+         std::shared_ptr<void> owner);
+
+  // Function to tell whether a width x height bitmap can be built; larger
+  // ones throw std::length_error (see indexedCells)
+  static bool fits(int width, int height);
+
+  Bitmap(const Bitmap &other);
+  Bitmap &operator=(const Bitmap &other);
+  Bitmap(Bitmap &&other) = default;
+  Bitmap &operator=(Bitmap &&other) = default;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // Bits per row, always a multiple of 64
+  int stride() const { return stride_; }
+  // Number of stored bits, border and padding included
+  int size() const { return (height_ + 2) * stride_; }
+
+  int index(int x, int y) const { return (y + 1) * stride_ + x + 1; }
+  int xOf(int index) const { return index % stride_ - 1; }
+  int yOf(int index) const { return index / stride_ - 1; }
+
+  bool test(int index) const { return (data[index >> 6] >> (index & 63)) & 1; }
+  void set(int index) { data[index >> 6] |= std::uint64_t(1) << (index & 63); }
+  void reset(int index) {
+    data[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+  }
+  void assign(int index, bool value) { value ? set(index) : reset(index); }
+  bool test(int x, int y) const { return test(index(x, y)); }
+
+  // Function to set bits first .. last (indices, inclusive) to value, whole
+  // words at a time
+  void fillRange(int first, int last, bool value);
+  // Function to set every in-maze bit (not the border) to value
+  void fill(bool value);
+  // Function to clear every bit, border included
+  void clear();
+
+  // Raw words; row y of the padded layout starts at word (y + 1) * rowWords()
+  int rowWords() const { return stride_ >> 6; }
+  std::size_t wordCount() const {
+    return std::size_t(height_ + 2) * rowWords();
+  }
+  std::uint64_t *words() { return data; }
+  const std::uint64_t *words() const { return data; }
+  std::size_t bytes() const { return wordCount() * sizeof(std::uint64_t); }
+
+private:
+  int width_, height_, stride_;
+  std::vector<std::uint64_t> bits; // empty when the words are borrowed
+  std::uint64_t *data;             // bits.data() or the borrowed words
+  std::shared_ptr<void> owner;     // keeps borrowed words alive
+};
+
+// Maze that stores only walls, one bit per cell (1 = WALL, border included).
+// It offers the same accessors as Grid, so generators and solvers run on it
+// directly, at 1/8 of the memory. Markers such as START or VISITED are not
+// stored: everything that is not WALL reads back as EMPTY, and solvers keep
+// their search state in separate arrays.
+class BitMaze {
+public:
+  BitMaze() {}
+  BitMaze(int width, int height, char fill = WALL)
+      : walls(width, height, fill == WALL, true) {}
+  // Maze over existing wall bits, whose border and padding must be set
+  explicit BitMaze(Bitmap wallBits) : walls(std::move(wallBits)) {}
+  static bool fits(int width, int height) {
+    return Bitmap::fits(width, height);
+  }
+
+  int width() const { return walls.width(); }
+  int height() const { return walls.height(); }
+  int stride() const { return walls.stride(); }
+  int size() const { return walls.size(); }
+  bool empty() const { return width() == 0 || height() == 0; }
+
+  int index(int x, int y) const { return walls.index(x, y); }
+  int xOf(int index) const { return walls.xOf(index); }
+  int yOf(int index) const { return walls.yOf(index); }
+  bool contains(int x, int y) const {
+    return x >= 0 && x < width() && y >= 0 && y < height();
+  }
+
+  char operator()(int x, int y) const { return (*this)[index(x, y)]; }
+  char operator[](int index) const { return walls.test(index) ? WALL : EMPTY; }
+  void set(int index, char value) { walls.assign(index, value == WALL); }
+  void set(int x, int y, char value) { set(index(x, y), value); }
+  void fillRow(int y, int first, int last, char value) {
+    walls.fillRange(index(first, y), index(last, y), value == WALL);
+  }
+  void fill(char value) { walls.fill(value == WALL); }
+
+  const Bitmap &wallBits() const { return walls; }
+  Bitmap &wallBits() { return walls; }
+
+private:
+  Bitmap walls;
+};
+
+// Function to pack a grid into wall bits (markers become EMPTY)
+BitMaze toBitMaze(const Grid &maze);
+// Function to expand wall bits into a grid of WALL and EMPTY cells
+Grid toGrid(const BitMaze &maze);
+
+#endif // MAZE_BITMAZE_H
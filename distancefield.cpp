@@ -0,0 +1,235 @@
+#include "distancefield.h"
+#include "definitions.h"
+#include <cstring>
+#include <fstream>
+
+// Directions: E, W, S, N, the order the solvers try them in
+static const int dx[4] = {1, -1, 0, 0};
+static const int dy[4] = {0, 0, 1, -1};
+
+DistanceField::DistanceField(const Grid &maze, int sourceX, int sourceY)
+    : width_(maze.width()), height_(maze.height()), sourceX_(sourceX),
+      sourceY_(sourceY) {
+  build(maze);
+}
+
+DistanceField::DistanceField(const BitMaze &maze, int sourceX, int sourceY)
+    : width_(maze.width()), height_(maze.height()), sourceX_(sourceX),
+      sourceY_(sourceY) {
+  build(maze);
+}
+
+template <class Maze> void DistanceField::build(const Maze &maze) {
+  dist.assign(static_cast<size_t>(width_) * height_, -1);
+  if (sourceX_ < 0 || sourceX_ >= width_ || sourceY_ < 0 ||
+      sourceY_ >= height_)
+    return;
+
+  // The search works on the maze's padded layout; keep the cells only
+  std::vector<int> padded;
+  reached = findDistancesBFS(maze, sourceX_, sourceY_, padded);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x)
+      dist[y * width_ + x] = padded[maze.index(x, y)];
+  }
+}
+
+int DistanceField::distance(int x, int y) const {
+  if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    return -1;
+  return dist[y * width_ + x];
+}
+
+SearchResult DistanceField::findPath(int startX, int startY) const {
+  SearchResult result;
+  int d = distance(startX, startY);
+  if (d < 0)
+    return result;
+
+  int x = startX;
+  int y = startY;
+  result.path.reserve(d + 1);
+  result.path.push_back(std::make_pair(x, y));
+  // Every cell at distance d > 0 has a neighbour at d - 1
+  for (; d > 0; --d) {
+    for (int k = 0; k < 4; ++k) {
+      if (distance(x + dx[k], y + dy[k]) == d - 1) {
+        x += dx[k];
+        y += dy[k];
+        break;
+      }
+    }
+    result.path.push_back(std::make_pair(x, y));
+  }
+  result.found = true;
+  return result;
+}
+
+// Cache file layout: magic, version, width, height, fingerprint and field
+// count, then per field its source and width * height distances (int32)
+static const char FILE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'D', 'I', 'S', 'T'};
+static const std::int32_t FILE_VERSION = 1;
+
+DistanceCache::DistanceCache(const Grid &maze) : grid(&maze), bits(nullptr) {
+  init(maze);
+}
+
+DistanceCache::DistanceCache(const BitMaze &maze)
+    : grid(nullptr), bits(&maze) {
+  init(maze);
+}
+
+template <class Maze> void DistanceCache::init(const Maze &maze) {
+  width = maze.width();
+  height = maze.height();
+  // FNV-1a over the dimensions and one wall flag per cell, so a Grid and the
+  // BitMaze packed from it share the fingerprint
+  fingerprint = 14695981039346656037ULL;
+  auto mix = [this](std::uint64_t value) {
+    fingerprint = (fingerprint ^ value) * 1099511628211ULL;
+  };
+  mix(width);
+  mix(height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x)
+      mix(maze(x, y) == WALL);
+  }
+}
+
+DistanceField *DistanceCache::compute(int sourceX, int sourceY) const {
+  if (grid)
+    return new DistanceField(*grid, sourceX, sourceY);
+  return new DistanceField(*bits, sourceX, sourceY);
+}
+
+int DistanceCache::key(int sourceX, int sourceY) const {
+  if (sourceX < 0 || sourceX >= width || sourceY < 0 || sourceY >= height)
+    return -1;
+  return sourceY * width + sourceX;
+}
+
+bool DistanceCache::contains(int sourceX, int sourceY) const {
+  return fields.count(key(sourceX, sourceY)) != 0;
+}
+
+const DistanceField &DistanceCache::field(int sourceX, int sourceY) {
+  int index = key(sourceX, sourceY);
+  if (index < 0) {
+    if (!outside)
+      outside.reset(compute(-1, -1));
+    return *outside;
+  }
+  std::unique_ptr<DistanceField> &entry = fields[index];
+  if (!entry)
+    entry.reset(compute(sourceX, sourceY));
+  return *entry;
+}
+
+void DistanceCache::build(const std::vector<std::pair<int, int> > &sources,
+                          ThreadPool &pool) {
+  std::vector<std::pair<int, int> > missing;
+  for (const std::pair<int, int> &source : sources) {
+    if (key(source.first, source.second) >= 0 &&
+        !contains(source.first, source.second))
+      missing.push_back(source);
+  }
+  // Each field is a full search, large enough to be a work item of its own
+  std::vector<std::unique_ptr<DistanceField> > built(missing.size());
+  pool.parallelFor(missing.size(), [&](int, int index) {
+    built[index].reset(compute(missing[index].first, missing[index].second));
+  });
+  for (size_t i = 0; i < missing.size(); ++i) {
+    std::unique_ptr<DistanceField> &entry =
+        fields[key(missing[i].first, missing[i].second)];
+    if (!entry) // the same source may be listed twice
+      entry = std::move(built[i]);
+  }
+}
+
+std::vector<int>
+DistanceCache::distanceTable(const std::vector<std::pair<int, int> > &sources,
+                             const std::vector<std::pair<int, int> > &targets,
+                             ThreadPool &pool) {
+  build(sources, pool);
+  std::vector<int> table(sources.size() * targets.size());
+  for (size_t s = 0; s < sources.size(); ++s) {
+    const DistanceField &from = field(sources[s].first, sources[s].second);
+    for (size_t t = 0; t < targets.size(); ++t)
+      table[s * targets.size() + t] =
+          from.distance(targets[t].first, targets[t].second);
+  }
+  return table;
+}
+
+bool DistanceCache::save(const std::string &filename) const {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  std::int32_t header[4] = {FILE_VERSION, width, height,
+                            static_cast<std::int32_t>(fields.size())};
+  file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(&fingerprint),
+             sizeof(fingerprint));
+  for (const auto &entry : fields) {
+    const DistanceField &field = *entry.second;
+    std::int32_t source[2] = {field.sourceX_, field.sourceY_};
+    file.write(reinterpret_cast<const char *>(source), sizeof(source));
+    file.write(reinterpret_cast<const char *>(field.dist.data()),
+               field.dist.size() * sizeof(std::int32_t));
+  }
+  return static_cast<bool>(file);
+}
+
+bool DistanceCache::load(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  char magic[sizeof(FILE_MAGIC)];
+  std::int32_t header[4];
+  std::uint64_t stored;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(header), sizeof(header));
+  file.read(reinterpret_cast<char *>(&stored), sizeof(stored));
+  if (!file || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 ||
+      header[0] != FILE_VERSION || header[1] != width ||
+      header[2] != height || header[3] < 0 || stored != fingerprint)
+    return false;
+  // The count comes from the file; check it against the file's size before
+  // allocating anything for it
+  long long fieldBytes =
+      sizeof(std::int32_t) * (2 + static_cast<long long>(width) * height);
+  std::streamoff start = file.tellg();
+  file.seekg(0, std::ios::end);
+  if (static_cast<long long>(file.tellg() - start) != header[3] * fieldBytes)
+    return false;
+  file.seekg(start);
+
+  // Read everything before touching the cache, so a truncated file adds
+  // nothing
+  std::vector<std::unique_ptr<DistanceField> > loaded(header[3]);
+  for (std::unique_ptr<DistanceField> &field : loaded) {
+    std::int32_t source[2];
+    file.read(reinterpret_cast<char *>(source), sizeof(source));
+    if (!file || source[0] < 0 || source[0] >= width || source[1] < 0 ||
+        source[1] >= height)
+      return false;
+    field.reset(new DistanceField());
+    field->width_ = width;
+    field->height_ = height;
+    field->sourceX_ = source[0];
+    field->sourceY_ = source[1];
+    field->dist.resize(static_cast<size_t>(width) * height);
+    file.read(reinterpret_cast<char *>(field->dist.data()),
+              field->dist.size() * sizeof(std::int32_t));
+    if (!file)
+      return false;
+    for (int d : field->dist)
+      field->reached += d >= 0;
+  }
+  for (std::unique_ptr<DistanceField> &field : loaded)
+    fields[key(field->sourceX_, field->sourceY_)] = std::move(field);
+  return true;
+}
@@ -0,0 +1,109 @@
+#ifndef MAZE_DISTANCEFIELD_H
+#define MAZE_DISTANCEFIELD_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "solver.h"
+#include "threadpool.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Steps from every cell of a maze to one source cell, from a single full BFS.
+// With the field in hand, any cell's distance to the source is a lookup and
+// its path is found by gradient descent: from a cell at distance d there is
+// always a neighbour at d - 1, so the walk takes O(path length) and no search.
+// Like JumpTable and TreeIndex, a field stays valid only as long as the
+// maze's walls do not change.
+class DistanceField {
+public:
+  DistanceField(const Grid &maze, int sourceX, int sourceY);
+  DistanceField(const BitMaze &maze, int sourceX, int sourceY);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int sourceX() const { return sourceX_; }
+  int sourceY() const { return sourceY_; }
+  // Number of cells that can reach the source, the source included
+  long reachedCells() const { return reached; }
+
+  // Function to return the number of steps from a cell to the source, or -1
+  // for walls, cells outside the maze and cells that cannot reach it
+  int distance(int x, int y) const;
+  // Function to return a shortest path from (startX, startY) to the source,
+  // both included; expanded stays 0 as nothing is searched
+  SearchResult findPath(int startX, int startY) const;
+
+private:
+  friend class DistanceCache; // reads and writes fields in files
+  DistanceField() = default;
+  template <class Maze> void build(const Maze &maze);
+
+  int width_ = 0, height_ = 0;
+  int sourceX_ = -1, sourceY_ = -1;
+  long reached = 0;
+  std::vector<int> dist; // steps of every cell (y * width + x), -1 if none
+};
+
+// Distance fields of one maze, computed once per source and kept for reuse,
+// e.g. the field of a fixed goal that every start is then measured against.
+// Sources can be added in bulk on the threads of a pool, and the whole cache
+// can be saved to a file and loaded back after a restart. A file records a
+// fingerprint of the maze's walls and is refused for any other maze.
+//
+// The maze must outlive the cache. field() and build() add entries and must
+// not run concurrently with each other; lookups on fields already returned
+// are safe from any thread.
+class DistanceCache {
+public:
+  explicit DistanceCache(const Grid &maze);
+  explicit DistanceCache(const BitMaze &maze);
+
+  // Number of cached sources
+  int size() const { return fields.size(); }
+  bool contains(int sourceX, int sourceY) const;
+  // Function to return the field of a source, computing it on first use. A
+  // source outside the maze gets one shared field with every distance -1,
+  // which is never counted, saved or listed by contains.
+  const DistanceField &field(int sourceX, int sourceY);
+  // Function to compute the fields of all given sources that are not cached
+  // yet, one source per worker at a time (sources outside the maze are
+  // skipped)
+  void build(const std::vector<std::pair<int, int> > &sources,
+             ThreadPool &pool);
+  // Function to return the distance from every target to every source,
+  // computing missing fields on pool first: entry s * targets.size() + t
+  // is the distance between targets[t] and sources[s], or -1
+  std::vector<int>
+  distanceTable(const std::vector<std::pair<int, int> > &sources,
+                const std::vector<std::pair<int, int> > &targets,
+                ThreadPool &pool);
+  void clear() { fields.clear(); }
+
+  // Function to write every cached field to a file; false if it cannot be
+  // written. The format is binary in the machine's byte order.
+  bool save(const std::string &filename) const;
+  // Function to add the fields stored in a file, replacing cached ones of the
+  // same sources; false (and nothing added) if the file cannot be read or
+  // was saved for a different maze
+  bool load(const std::string &filename);
+
+private:
+  template <class Maze> void init(const Maze &maze);
+  DistanceField *compute(int sourceX, int sourceY) const;
+  // Function to return the map key of a source, -1 outside the maze
+  int key(int sourceX, int sourceY) const;
+
+  const Grid *grid; // the bound maze, exactly one of grid and bits is set
+  const BitMaze *bits;
+  int width, height;
+  std::uint64_t fingerprint; // hash of the wall layout
+  // Fields by source cell (y * width + x)
+  std::map<int, std::unique_ptr<DistanceField> > fields;
+  std::unique_ptr<DistanceField> outside; // of every source outside the maze
+};
+
+#endif // MAZE_DISTANCEFIELD_H
@@ -0,0 +1,363 @@
+#include "engine.h"
+#include "bitbfs.h"
+#include "definitions.h"
+#include "generator.h"
+#include "graph.h"
+#include "grid.h"
+#include "jumptable.h"
+#include "parallelbfs.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "treeindex.h"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+bool parseGeneratorType(const std::string &name, GeneratorType &type) {
+  if (name == "dfs")
+    type = GENERATOR_DFS;
+  else if (name == "prims")
+    type = GENERATOR_PRIMS;
+  else if (name == "division")
+    type = GENERATOR_DIVISION;
+  else if (name == "kruskals")
+    type = GENERATOR_KRUSKALS;
+  else if (name == "ellers")
+    type = GENERATOR_ELLERS;
+  else if (name == "wilsons")
+    type = GENERATOR_WILSONS;
+  else if (name == "aldousbroder")
+    type = GENERATOR_ALDOUS_BRODER;
+  else
+    return false;
+  return true;
+}
+
+bool parseSolverType(const std::string &name, SolverType &type) {
+  if (name == "dfs")
+    type = SOLVER_DFS;
+  else if (name == "bfs")
+    type = SOLVER_BFS;
+  else if (name == "dijkstra")
+    type = SOLVER_DIJKSTRA;
+  else if (name == "astar")
+    type = SOLVER_ASTAR;
+  else if (name == "bibfs")
+    type = SOLVER_BIDIRECTIONAL_BFS;
+  else if (name == "biastar")
+    type = SOLVER_BIDIRECTIONAL_ASTAR;
+  else if (name == "jps")
+    type = SOLVER_JPS;
+  else if (name == "jpsplus")
+    type = SOLVER_JPS_PLUS;
+  else if (name == "tree")
+    type = SOLVER_TREE_INDEX;
+  else if (name == "bitbfs")
+    type = SOLVER_BIT_BFS;
+  else if (name == "pbfs")
+    type = SOLVER_PARALLEL_BFS;
+  else
+    return false;
+  return true;
+}
+
+bool parseOpenListType(const std::string &name, OpenListType &type) {
+  if (name == "binary")
+    type = OPEN_BINARY_HEAP;
+  else if (name == "quad")
+    type = OPEN_QUAD_HEAP;
+  else if (name == "bucket")
+    type = OPEN_BUCKET_QUEUE;
+  else if (name == "indexed")
+    type = OPEN_INDEXED_HEAP;
+  else
+    return false;
+  return true;
+}
+
+void (*carverFor(GeneratorType type))(Grid &, MazeRandom &, MazeSink &) {
+  switch (type) {
+  case GENERATOR_PRIMS:
+    return randomizedPrims;
+  case GENERATOR_DIVISION:
+    return recursiveDivision;
+  case GENERATOR_KRUSKALS:
+    return randomizedKruskals;
+  case GENERATOR_ELLERS:
+    return randomizedEllers;
+  case GENERATOR_WILSONS:
+    return randomizedWilsons;
+  case GENERATOR_ALDOUS_BRODER:
+    return randomizedAldousBroder;
+  case GENERATOR_DFS:
+  default:
+    return randomizedDFS;
+  }
+}
+
+Grid generateMazeWith(GeneratorType type, int width, int height,
+                      MazeSink &sink, std::uint64_t seed) {
+  return generateMaze(width, height, carverFor(type), sink, seed);
+}
+
+// Function to show a path found without a search on sink
+static void reportPath(const Grid &maze, const SearchResult &result,
+                       MazeSink &sink) {
+  sink.reset(maze);
+  for (size_t i = 1; i + 1 < result.path.size(); ++i) {
+    sink.cell(result.path[i].first, result.path[i].second, PATH);
+    sink.step();
+  }
+}
+
+SearchResult solveMazeWith(SolverType type, const Grid &maze, int startX, int startY,
+                           int goalX, int goalY, MazeSink &sink,
+                           OpenListType openList) {
+  switch (type) {
+  case SOLVER_BFS:
+    return findPathBFS(maze, startX, startY, goalX, goalY, sink);
+  case SOLVER_DIJKSTRA:
+    return findPathDijkstra(maze, startX, startY, goalX, goalY, sink,
+                            openList);
+  case SOLVER_ASTAR:
+    return findPathAStar(maze, startX, startY, goalX, goalY,
+                         defaultHeuristic, sink, openList);
+  case SOLVER_BIDIRECTIONAL_BFS:
+    return findPathBidirectionalBFS(maze, startX, startY, goalX, goalY, sink);
+  case SOLVER_BIDIRECTIONAL_ASTAR:
+    return findPathBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                      defaultHeuristic, sink, openList);
+  case SOLVER_JPS:
+    return findPathJPS(maze, startX, startY, goalX, goalY, defaultHeuristic,
+                       sink, openList);
+  case SOLVER_JPS_PLUS:
+    return findPathJPS(maze, JumpTable(maze), startX, startY, goalX, goalY,
+                       defaultHeuristic, sink, openList);
+  case SOLVER_TREE_INDEX: {
+    TreeIndex index(maze);
+    if (!index.isTree())
+      return findPathBFS(maze, startX, startY, goalX, goalY, sink);
+    SearchResult result = index.findPath(startX, startY, goalX, goalY);
+    reportPath(maze, result, sink);
+    return result;
+  }
+  case SOLVER_BIT_BFS:
+    return findPathBitBFS(maze, startX, startY, goalX, goalY, sink);
+  case SOLVER_PARALLEL_BFS: {
+    ThreadPool pool;
+    return findPathParallelBFS(maze, startX, startY, goalX, goalY, pool, sink);
+  }
+  case SOLVER_DFS:
+  default:
+    return findPathDFS(maze, startX, startY, goalX, goalY, sink);
+  }
+}
+
+bool supportsContraction(SolverType type) {
+  return type == SOLVER_BFS || type == SOLVER_DIJKSTRA || type == SOLVER_ASTAR;
+}
+
+// Function to solve one query on the junction graph with the given algorithm
+static SearchResult solveGraphWith(SolverType type, const JunctionGraph &graph,
+                                   int startX, int startY, int goalX,
+                                   int goalY, OpenListType openList) {
+  switch (type) {
+  case SOLVER_BFS:
+    return findPathBFS(graph, startX, startY, goalX, goalY);
+  case SOLVER_DIJKSTRA:
+    return findPathDijkstra(graph, startX, startY, goalX, goalY, nullSink(),
+                            openList);
+  case SOLVER_ASTAR:
+  default:
+    return findPathAStar(graph, startX, startY, goalX, goalY,
+                         defaultHeuristic, nullSink(), openList);
+  }
+}
+
+// What a batch builds from its maze once and shares read-only between the
+// workers; only the parts its solver needs are set
+struct BatchTables {
+  std::unique_ptr<JumpTable> jumps;  // JPS+
+  std::unique_ptr<TreeIndex> tree;   // tree solver
+  std::unique_ptr<BitBlocks> blocks; // bit-parallel BFS
+
+  template <class Maze> BatchTables(SolverType type, const Maze &maze) {
+    if (type == SOLVER_JPS_PLUS)
+      jumps.reset(new JumpTable(maze));
+    if (type == SOLVER_TREE_INDEX)
+      tree.reset(new TreeIndex(maze));
+    if (type == SOLVER_BIT_BFS)
+      blocks.reset(new BitBlocks(maze));
+  }
+};
+
+// Function to run one query on a context with the given algorithm
+static SearchResult solveWith(SolverType type, SolverContext &context,
+                              const PathQuery &query, OpenListType openList,
+                              const BatchTables &tables) {
+  switch (type) {
+  case SOLVER_BFS:
+    return context.findPathBFS(query.startX, query.startY, query.goalX,
+                               query.goalY);
+  case SOLVER_DIJKSTRA:
+    return context.findPathDijkstra(query.startX, query.startY, query.goalX,
+                                    query.goalY, nullSink(), openList);
+  case SOLVER_ASTAR:
+    return context.findPathAStar(query.startX, query.startY, query.goalX,
+                                 query.goalY, defaultHeuristic, nullSink(),
+                                 openList);
+  case SOLVER_BIDIRECTIONAL_BFS:
+    return context.findPathBidirectionalBFS(query.startX, query.startY,
+                                            query.goalX, query.goalY);
+  case SOLVER_BIDIRECTIONAL_ASTAR:
+    return context.findPathBidirectionalAStar(
+        query.startX, query.startY, query.goalX, query.goalY,
+        defaultHeuristic, nullSink(), openList);
+  case SOLVER_JPS:
+    return context.findPathJPS(query.startX, query.startY, query.goalX,
+                               query.goalY, defaultHeuristic, nullSink(),
+                               openList);
+  case SOLVER_JPS_PLUS:
+    return context.findPathJPS(*tables.jumps, query.startX, query.startY,
+                               query.goalX, query.goalY, defaultHeuristic,
+                               nullSink(), openList);
+  case SOLVER_PARALLEL_BFS:
+    return context.findPathBFS(query.startX, query.startY, query.goalX,
+                               query.goalY);
+  case SOLVER_TREE_INDEX:
+    if (tables.tree->isTree())
+      return tables.tree->findPath(query.startX, query.startY, query.goalX,
+                                   query.goalY);
+    return context.findPathBFS(query.startX, query.startY, query.goalX,
+                               query.goalY);
+  case SOLVER_BIT_BFS:
+    return context.findPathBitBFS(*tables.blocks, query.startX, query.startY,
+                                  query.goalX, query.goalY);
+  case SOLVER_DFS:
+  default:
+    return context.findPathDFS(query.startX, query.startY, query.goalX,
+                               query.goalY);
+  }
+}
+
+template <class Maze>
+static std::vector<SearchResult>
+solveQueries(SolverType type, const Maze &maze,
+             const std::vector<PathQuery> &queries, ThreadPool &pool,
+             OpenListType openList) {
+  std::vector<SearchResult> results(queries.size());
+  // Contexts are created by their own worker on first use, so each one's
+  // buffers are allocated (and first touched) by the thread that uses them
+  std::vector<std::unique_ptr<SolverContext> > contexts(pool.size());
+  BatchTables tables(type, maze);
+  pool.parallelFor(queries.size(), [&](int worker, int index) {
+    if (!contexts[worker])
+      contexts[worker].reset(new SolverContext(maze));
+    results[index] =
+        solveWith(type, *contexts[worker], queries[index], openList, tables);
+  });
+  return results;
+}
+
+std::vector<SearchResult> solveBatch(SolverType type, const Grid &maze,
+                                     const std::vector<PathQuery> &queries,
+                                     ThreadPool &pool, OpenListType openList) {
+  return solveQueries(type, maze, queries, pool, openList);
+}
+std::vector<SearchResult> solveBatch(SolverType type, const BitMaze &maze,
+                                     const std::vector<PathQuery> &queries,
+                                     ThreadPool &pool, OpenListType openList) {
+  return solveQueries(type, maze, queries, pool, openList);
+}
+
+std::vector<PathQuery> randomQueries(const Grid &maze, int count,
+                                     unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> column(0, maze.width() - 1);
+  std::uniform_int_distribution<int> row(0, maze.height() - 1);
+  std::vector<PathQuery> queries;
+  // Drawing cells until one is open would never end without any
+  bool open = false;
+  for (int y = 0; y < maze.height() && !open; ++y)
+    for (int x = 0; x < maze.width() && !open; ++x)
+      open = maze(x, y) != WALL;
+  if (!open)
+    return queries;
+  queries.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    PathQuery query;
+    do {
+      query.startX = column(gen);
+      query.startY = row(gen);
+    } while (maze(query.startX, query.startY) == WALL);
+    do {
+      query.goalX = column(gen);
+      query.goalY = row(gen);
+    } while (maze(query.goalX, query.goalY) == WALL);
+    queries.push_back(query);
+  }
+  return queries;
+}
+
+EngineResult runHeadless(int width, int height, GeneratorType generator,
+                         SolverType solver, OpenListType openList,
+                         const PreprocessOptions &preprocess,
+                         std::uint64_t seed) {
+  typedef std::chrono::steady_clock Clock;
+  EngineResult run;
+
+  run.seed = seed;
+  Clock::time_point t0 = Clock::now();
+  run.maze = generateMazeWith(generator, width, height, nullSink(), seed);
+  Clock::time_point t1 = Clock::now();
+
+  int startX = 1;
+  int startY = 1;
+  int goalX = run.maze.width() - 2;
+  int goalY = run.maze.height() - 2;
+  run.maze(startX, startY) = START;
+  run.maze(goalX, goalY) = GOAL;
+
+  // The graph is built as part of preprocessing, so solve_ms only covers the
+  // search itself, as it would when the graph is reused for many queries
+  std::unique_ptr<JunctionGraph> graph;
+  if (preprocess.fillDeadEnds) {
+    std::vector<std::pair<int, int> > keep;
+    keep.push_back(std::make_pair(startX, startY));
+    keep.push_back(std::make_pair(goalX, goalY));
+    run.filledCells = fillDeadEnds(run.maze, keep);
+  }
+  if (preprocess.contract && supportsContraction(solver)) {
+    graph.reset(new JunctionGraph(run.maze));
+    run.graphNodes = graph->nodeCount();
+    run.graphEdges = graph->edgeCount();
+  }
+  Clock::time_point t2 = Clock::now();
+  if (graph) {
+    run.openCells = graph->openCells();
+  } else {
+    for (int y = 0; y < run.maze.height(); ++y)
+      for (int x = 0; x < run.maze.width(); ++x)
+        run.openCells += run.maze(x, y) != WALL;
+  }
+
+  Clock::time_point t3 = Clock::now();
+  if (graph)
+    run.search = solveGraphWith(solver, *graph, startX, startY, goalX, goalY,
+                                openList);
+  else
+    run.search = solveMazeWith(solver, run.maze, startX, startY, goalX, goalY,
+                               nullSink(), openList);
+  Clock::time_point t4 = Clock::now();
+  markPath(run.maze, run.search);
+
+  run.generateMillis =
+      std::chrono::duration<double, std::milli>(t1 - t0).count();
+  run.preprocessMillis =
+      std::chrono::duration<double, std::milli>(t2 - t1).count();
+  run.solveMillis = std::chrono::duration<double, std::milli>(t4 - t3).count();
+  return run;
+}
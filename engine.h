@@ -0,0 +1,128 @@
+#ifndef MAZE_ENGINE_H
+#define MAZE_ENGINE_H
+
+#include "grid.h"
+#include "openlist.h"
+#include "random.h"
+#include "sink.h"
+#include "solver.h"
+#include "threadpool.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Maze generation algorithms, numbered as in the interactive menu
+enum GeneratorType {
+  GENERATOR_DFS = 1,
+  GENERATOR_PRIMS,
+  GENERATOR_DIVISION,
+  GENERATOR_KRUSKALS,
+  GENERATOR_ELLERS,
+  GENERATOR_WILSONS,
+  GENERATOR_ALDOUS_BRODER
+};
+
+// Maze solving algorithms, numbered as in the interactive menu
+enum SolverType {
+  SOLVER_DFS = 1,
+  SOLVER_BFS,
+  SOLVER_DIJKSTRA,
+  SOLVER_ASTAR,
+  SOLVER_BIDIRECTIONAL_BFS,
+  SOLVER_BIDIRECTIONAL_ASTAR,
+  SOLVER_JPS,
+  SOLVER_JPS_PLUS,
+  SOLVER_TREE_INDEX,
+  SOLVER_BIT_BFS,
+  SOLVER_PARALLEL_BFS
+};
+
+// Optional preprocessing of a headless run, done between generating and
+// solving the maze (see graph.h)
+struct PreprocessOptions {
+  bool fillDeadEnds = false; // wall up dead ends, keeping start and goal
+  bool contract = false;     // search the junction graph (BFS, Dijkstra, A*)
+};
+
+// Everything a headless run produces: the maze with the path drawn in, the
+// search outcome and how long each phase took
+struct EngineResult {
+  Grid maze;
+  SearchResult search;
+  std::uint64_t seed = 0; // the maze was generated from
+  double generateMillis = 0;
+  double preprocessMillis = 0;
+  double solveMillis = 0;
+  long filledCells = 0; // cells walled up by dead-end filling
+  long openCells = 0;   // open cells searched over, after filling
+  int graphNodes = 0;   // junction graph size when contracted
+  int graphEdges = 0;
+};
+
+// One path query of a batch
+struct PathQuery {
+  int startX, startY;
+  int goalX, goalY;
+};
+
+// Function to look up a generator by its command line name
+// (dfs, prims, division, kruskals, ellers, wilsons, aldousbroder)
+bool parseGeneratorType(const std::string &name, GeneratorType &type);
+// Function to look up a solver by its command line name
+// (dfs, bfs, dijkstra, astar, bibfs, biastar, jps, jpsplus, tree, bitbfs,
+// pbfs)
+bool parseSolverType(const std::string &name, SolverType &type);
+// Function to look up an open list by its command line name
+// (binary, quad, bucket, indexed)
+bool parseOpenListType(const std::string &name, OpenListType &type);
+// Function to return the Grid carver of a generator (see generator.h), e.g.
+// to pass to generateTiledMaze
+void (*carverFor(GeneratorType type))(Grid &, MazeRandom &, MazeSink &);
+// Function to generate a maze with the given algorithm (the same seed gives
+// the same maze)
+Grid generateMazeWith(GeneratorType type, int width, int height,
+                      MazeSink &sink = nullSink(),
+                      std::uint64_t seed = randomSeed());
+// Function to solve a maze with the given algorithm
+// (openList only matters for Dijkstra, the A* variants and JPS; JPS+ builds
+// its jump table and the tree solver its TreeIndex first, and the tree solver
+// falls back to BFS on mazes with loops; the parallel BFS runs on a pool of
+// one thread per core)
+SearchResult solveMazeWith(SolverType type, const Grid &maze, int startX, int startY,
+                           int goalX, int goalY,
+                           MazeSink &sink = nullSink(),
+                           OpenListType openList = OPEN_BUCKET_QUEUE);
+// Function to tell whether a solver can run on the junction graph
+bool supportsContraction(SolverType type);
+// Function to solve every query against one maze on the threads of pool. The
+// maze is shared read-only; each worker runs its queries on its own
+// SolverContext. JPS+ builds one jump table and the tree solver one
+// TreeIndex for the whole batch. The parallel BFS would need the pool the
+// queries already run on, so a batch runs plain BFS for it instead. Results
+// are returned in query order (path length is path.size() - 1 for a found
+// path).
+std::vector<SearchResult> solveBatch(SolverType type, const Grid &maze,
+                                     const std::vector<PathQuery> &queries,
+                                     ThreadPool &pool,
+                                     OpenListType openList = OPEN_BUCKET_QUEUE);
+std::vector<SearchResult> solveBatch(SolverType type, const BitMaze &maze,
+                                     const std::vector<PathQuery> &queries,
+                                     ThreadPool &pool,
+                                     OpenListType openList = OPEN_BUCKET_QUEUE);
+// Function to pick count queries between random open cells of maze, the same
+// ones for the same seed; none if the maze has no open cell
+std::vector<PathQuery> randomQueries(const Grid &maze, int count,
+                                     unsigned seed = 1);
+// Function to generate and solve a maze with a NullSink, i.e. without any
+// rendering or delays.
+// Start and goal are placed in opposite corners, as in the interactive mode.
+// Contraction only applies to solvers with supportsContraction; the others
+// search the cells as usual. Runs with the same seed solve the same maze.
+EngineResult runHeadless(int width, int height, GeneratorType generator,
+                         SolverType solver,
+                         OpenListType openList = OPEN_BUCKET_QUEUE,
+                         const PreprocessOptions &preprocess =
+                             PreprocessOptions(),
+                         std::uint64_t seed = randomSeed());
+
+#endif // MAZE_ENGINE_H
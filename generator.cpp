@@ -1,75 +1,77 @@
+#include "bitmaze.h"
 #include "definitions.h"
-#include "utils.h"
-#include <algorithm>  // For std::shuffle
-#include <cstdlib>    // For rand() and srand()
-#include <ctime>      // For time()
-#include <functional> // For std::function
-#include <random>     // For std::mt19937
-#include <stack>
+#include "generator.h"
+#include "grid.h"
+#include "random.h"
+#include "sink.h"
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 // Directions: N, S, E, W
 const int dx[4] = {0, 0, 1, -1};
 const int dy[4] = {1, -1, 0, 0};
 
-class UnionFind {
-public:
-  std::vector<int> parent;
-  std::vector<int> rank;
-
-  UnionFind(int size) {
-    parent.resize(size);
-    rank.resize(size, 0);
-    for (int i = 0; i < size; i++) {
-      parent[i] = i;
-    }
+UnionFind::UnionFind(int size) {
+  parent.resize(size);
+  rank.resize(size, 0);
+  for (int i = 0; i < size; i++) {
+    parent[i] = i;
   }
+}
 
-  int find(int x) {
-    if (parent[x] != x) {
-      parent[x] = find(parent[x]);
-    }
-    return parent[x];
+int UnionFind::find(int x) {
+  if (parent[x] != x) {
+    parent[x] = find(parent[x]);
   }
+  return parent[x];
+}
 
-  void unite(int x, int y) {
-    int rootX = find(x);
-    int rootY = find(y);
-    if (rootX != rootY) {
-      if (rank[rootX] > rank[rootY]) {
-        parent[rootY] = rootX;
-      } else if (rank[rootX] < rank[rootY]) {
-        parent[rootX] = rootY;
-      } else {
-        parent[rootY] = rootX;
-        rank[rootX]++;
-      }
+void UnionFind::unite(int x, int y) {
+  int rootX = find(x);
+  int rootY = find(y);
+  if (rootX != rootY) {
+    if (rank[rootX] > rank[rootY]) {
+      parent[rootY] = rootX;
+    } else if (rank[rootX] < rank[rootY]) {
+      parent[rootX] = rootY;
+    } else {
+      parent[rootY] = rootX;
+      rank[rootX]++;
     }
   }
-};
-void randomizedKruskals(std::vector<std::vector<char> > &maze) {
-  std::random_device rd;  // Obtain a random number from hardware
-  std::mt19937 gen(rd()); // Seed the generator
-  srand(time(nullptr));   // Seed random number generation
+}
+
+// The carving algorithms are written once against the accessors shared by
+// Grid and BitMaze (operator(), set, fill, index, stride) and instantiated
+// for both by the public functions at the end of this file.
 
-  int height = maze.size();
-  int width = maze[0].size();
-  UnionFind uf(width * height);
+template <class Maze>
+void carveKruskals(Maze &maze, MazeRandom &random, MazeSink &sink) {
+  int height = maze.height();
+  int width = maze.width();
+  UnionFind uf(maze.size());
 
+  // Edges join two cells by their grid index
   std::vector<std::pair<int, int> > edges;
   // Initialize the maze and collect possible edges
   for (int y = 1; y < height - 1; y += 2) {
     for (int x = 1; x < width - 1; x += 2) {
-      maze[y][x] = EMPTY;
+      int cell = maze.index(x, y);
+      maze.set(cell, EMPTY);
       if (x < width - 2)
-        edges.emplace_back(y * width + x, y * width + x + 2);
+        edges.emplace_back(cell, cell + 2);
       if (y < height - 2)
-        edges.emplace_back(y * width + x, (y + 2) * width + x);
+        edges.emplace_back(cell, cell + 2 * maze.stride());
     }
   }
 
-  // Shuffle edges to ensure random order
-  std::shuffle(edges.begin(), edges.end(), gen);
+  sink.reset(maze);
+
+  // Shuffle edges to ensure random order (Fisher-Yates by hand: the
+  // algorithm behind std::shuffle differs between standard libraries)
+  for (int i = edges.size() - 1; i > 0; --i)
+    std::swap(edges[i], edges[random.below(i + 1)]);
 
   // Process each edge
   for (auto &edge : edges) {
@@ -78,216 +80,544 @@ void randomizedKruskals(std::vector<std::vector<char> > &maze) {
     if (uf.find(cell1) != uf.find(cell2)) {
       uf.unite(cell1, cell2);
       int inbetween = (cell1 + cell2) / 2;
-      maze[inbetween / width][inbetween % width] = EMPTY;
-      renderMaze(maze);
+      maze.set(inbetween, EMPTY);
+      sink.cell(maze.xOf(inbetween), maze.yOf(inbetween), EMPTY);
+      sink.step();
     }
   }
 }
 
-char chooseOrientation(int width, int height) {
-  if (width < height)
-    return 'h';
-  else if (height < width)
-    return 'v';
-  else
-    return rand() % 2 ? 'h' : 'v';
-}
-void divide(std::vector<std::vector<char> > &maze, int yStart, int yEnd, int xStart, int xEnd) {
-    int yDim = yEnd - yStart;
-    int xDim = xEnd - xStart;
-    
+// Chamber still to be divided by recursiveDivision: rows yStart .. yEnd and
+// columns xStart .. xEnd, all odd
+struct Chamber {
+  int yStart, yEnd, xStart, xEnd;
+};
+
+template <class Maze>
+void divide(Maze &maze, int yStart, int yEnd, int xStart, int xEnd,
+            MazeRandom &random, MazeSink &sink) {
+  // Chambers wait on an explicit stack instead of the call stack, so the
+  // depth of the division is limited by memory only. The second half is
+  // pushed first, which keeps the order of the recursive version.
+  std::vector<Chamber> stack;
+  stack.push_back(Chamber{yStart, yEnd, xStart, xEnd});
+  while (!stack.empty()) {
+    Chamber chamber = stack.back();
+    stack.pop_back();
+    int yDim = chamber.yEnd - chamber.yStart;
+    int xDim = chamber.xEnd - chamber.xStart;
     if (yDim <= 0 || xDim <= 0)
-        return;
-    bool horizontal = chooseOrientation(xDim, yDim) == 'h';
-    int split, hole;
+      continue;
 
+    // Cut across the longer side (either one for squares). Walls go on the
+    // even lines strictly inside the chamber and the hole on an odd cell of
+    // the wall, both picked directly from the valid positions.
+    bool horizontal = xDim < yDim || (xDim == yDim && random.coin());
     if (horizontal) {
-        do {
-            split = std::rand() % (yDim + 1) + yStart;
-        } while (split % 2 != 0);
-
-        do {
-            hole = std::rand() % (xDim + 1) + xStart;
-        } while (hole % 2 == 0);
-
-        for (int j = xStart; j <= xEnd; j++) {
-            if (j != hole)
-                maze[split][j] = WALL;
+      int split = chamber.yStart + 1 + 2 * random.below(yDim / 2);
+      int hole = chamber.xStart + 2 * random.below(xDim / 2 + 1);
+
+      if (hole > chamber.xStart)
+        maze.fillRow(split, chamber.xStart, hole - 1, WALL);
+      if (hole < chamber.xEnd)
+        maze.fillRow(split, hole + 1, chamber.xEnd, WALL);
+      if (sink.active()) {
+        for (int x = chamber.xStart; x <= chamber.xEnd; ++x) {
+          if (x != hole)
+            sink.cell(x, split, WALL);
         }
-        renderMaze(maze);
+        sink.step();
+      }
 
-        divide(maze, yStart, split - 1, xStart, xEnd);
-        divide(maze, split + 1, yEnd, xStart, xEnd);
+      stack.push_back(
+          Chamber{split + 1, chamber.yEnd, chamber.xStart, chamber.xEnd});
+      stack.push_back(
+          Chamber{chamber.yStart, split - 1, chamber.xStart, chamber.xEnd});
     } else {
-        do {
-            split = std::rand() % (xDim + 1) + xStart;
-        } while (split % 2 != 0);
-
-        do {
-            hole = std::rand() % (yDim + 1) + yStart;
-        } while (hole % 2 == 0);
+      int split = chamber.xStart + 1 + 2 * random.below(xDim / 2);
+      int hole = chamber.yStart + 2 * random.below(yDim / 2 + 1);
 
-        for (int i = yStart; i <= yEnd; i++) {
-            if (i != hole)
-                maze[i][split] = WALL;
+      for (int y = chamber.yStart; y <= chamber.yEnd; ++y) {
+        if (y != hole) {
+          maze.set(split, y, WALL);
+          sink.cell(split, y, WALL);
         }
-        renderMaze(maze);
+      }
+      sink.step();
 
-        divide(maze, yStart, yEnd, xStart, split - 1);
-        divide(maze, yStart, yEnd, split + 1, xEnd);
+      stack.push_back(
+          Chamber{chamber.yStart, chamber.yEnd, split + 1, chamber.xEnd});
+      stack.push_back(
+          Chamber{chamber.yStart, chamber.yEnd, chamber.xStart, split - 1});
     }
+  }
 }
-void recursiveDivision(std::vector<std::vector<char> > &maze) {
-  srand(time(nullptr)); // Seed random generator
-
-  int height = maze.size();
-  int width = maze[0].size();
-
-  // Initialize the maze with walls
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      maze[y][x] = (y == 0 || x == 0 || y == height - 1 || x == width - 1)
-                       ? WALL
-                       : EMPTY;
-    }
+template <class Maze>
+void carveDivision(Maze &maze, MazeRandom &random, MazeSink &sink) {
+  int height = maze.height();
+  int width = maze.width();
+
+  // Initialize the maze: open inside, walls around
+  maze.fill(EMPTY);
+  maze.fillRow(0, 0, width - 1, WALL);
+  maze.fillRow(height - 1, 0, width - 1, WALL);
+  for (int y = 1; y < height - 1; ++y) {
+    maze.set(0, y, WALL);
+    maze.set(width - 1, y, WALL);
   }
-  /* renderMaze(maze); */
+  sink.reset(maze);
   // Start the division
-  divide(maze, 1, height - 2, 1, width - 2);
-}
-
-std::vector<std::pair<int, int> >
-getUnvisitedNeighbors(int x, int y, std::vector<std::vector<char> > &maze) {
-  std::vector<std::pair<int, int> > neighbors;
-  for (int i = 0; i < 4; ++i) {
-    int nx = x + dx[i] * 2;
-    int ny = y + dy[i] * 2;
-    if (nx > 0 && nx < maze[0].size() && ny > 0 && ny < maze.size() &&
-        maze[ny][nx] == WALL) {
-      neighbors.push_back({nx, ny});
-    }
-  }
-  return neighbors;
+  divide(maze, 1, height - 2, 1, width - 2, random, sink);
 }
 
-void randomizedPrims(std::vector<std::vector<char> > &maze) {
-  srand(time(nullptr)); // Seed random number generation
+// Function to list the directions (indices into dx, dy) in which the cell two
+// steps from (x, y) is inside the maze and still a wall, i.e. not carved yet;
+// returns how many were written to found
+template <class Maze>
+static int wallNeighbors(const Maze &maze, int x, int y, int (&found)[4]) {
+  int count = 0;
+  for (int k = 0; k < 4; ++k) {
+    int nx = x + dx[k] * 2;
+    int ny = y + dy[k] * 2;
+    if (nx > 0 && nx < maze.width() && ny > 0 && ny < maze.height() &&
+        maze(nx, ny) == WALL)
+      found[count++] = k;
+  }
+  return count;
+}
 
+template <class Maze>
+void carvePrims(Maze &maze, MazeRandom &random, MazeSink &sink) {
   // Initialize the maze with walls
-  for (int y = 0; y < maze.size(); ++y) {
-    for (int x = 0; x < maze[0].size(); ++x) {
-      maze[y][x] = WALL;
-    }
-  }
+  maze.fill(WALL);
+  sink.reset(maze);
 
   // Initialize the starting point
-  int startX = 1 + rand() % (maze[0].size() / 2) * 2;
-  int startY = 1 + rand() % (maze.size() / 2) * 2;
-
-  // Initialize the list with the starting point
+  int startX = 1 + random.below(maze.width() / 2) * 2;
+  int startY = 1 + random.below(maze.height() / 2) * 2;
+
+  // Open the starting point, or a later step carves into it again and
+  // closes a loop
+  maze.set(startX, startY, EMPTY);
+  sink.cell(startX, startY, EMPTY);
+
+  // Carved cells that may still have uncarved neighbours. A cell joins once,
+  // when it is carved (its EMPTY mark keeps it from being added again), and
+  // leaves by swapping the last entry into its place, so the order of the
+  // list does not matter and nothing is shifted.
   std::vector<std::pair<int, int> > list;
+  list.reserve((maze.width() / 2) * (maze.height() / 2));
   list.push_back(std::make_pair(startX, startY));
 
+  int neighbors[4];
   while (!list.empty()) {
     // Randomly select a cell from the list
-    int index = rand() % list.size();
+    int index = random.below(list.size());
     int x = list[index].first;
     int y = list[index].second;
-    auto neighbors = getUnvisitedNeighbors(x, y, maze);
 
     // If the cell has no unvisited neighbors, remove it from the list
-    // and continue to the next cell
-    while (neighbors.empty()) {
-      list.erase(list.begin() + index);
-      if (list.empty()) {
-        return;
-      }
-      index = rand() % list.size();
-      x = list[index].first;
-      y = list[index].second;
-      neighbors = getUnvisitedNeighbors(x, y, maze);
+    // and continue with another cell
+    int count = wallNeighbors(maze, x, y, neighbors);
+    if (count == 0) {
+      list[index] = list.back();
+      list.pop_back();
+      continue;
     }
 
     // Randomly select a neighbor
-    int nextIndex = rand() % neighbors.size();
-    int nx = neighbors[nextIndex].first;
-    int ny = neighbors[nextIndex].second;
+    int k = neighbors[random.below(count)];
+    int nx = x + dx[k] * 2;
+    int ny = y + dy[k] * 2;
 
     // Remove the wall between the current cell and the selected neighbor
-    maze[ny][nx] = EMPTY;
-    maze[(y + ny) / 2][(x + nx) / 2] = EMPTY;
-    renderMaze(maze);
+    maze.set(nx, ny, EMPTY);
+    maze.set(x + dx[k], y + dy[k], EMPTY);
+    sink.cell(nx, ny, EMPTY);
+    sink.cell(x + dx[k], y + dy[k], EMPTY);
+    sink.step();
 
     list.push_back(std::make_pair(nx, ny));
   }
 }
 
-void randomizedDFS(std::vector<std::vector<char> > &maze) {
-  srand(time(nullptr)); // Seed random number generation
-
+// Number of set bits and position of the n-th set bit of every 4-bit
+// direction mask (-1: none), to pick a random open direction without looping
+// over the four
+static const int directionCount[16] = {0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4};
+static const signed char nthDirection[16][4] = {
+    {-1, -1, -1, -1}, {0, -1, -1, -1}, {1, -1, -1, -1}, {0, 1, -1, -1},
+    {2, -1, -1, -1},  {0, 2, -1, -1},  {1, 2, -1, -1},  {0, 1, 2, -1},
+    {3, -1, -1, -1},  {0, 3, -1, -1},  {1, 3, -1, -1},  {0, 1, 3, -1},
+    {2, 3, -1, -1},   {0, 2, 3, -1},   {1, 2, 3, -1},   {0, 1, 2, 3}};
+
+template <class Maze>
+void carveDFS(Maze &maze, MazeRandom &random, MazeSink &sink) {
   // Initialize the maze with walls
-  for (int y = 0; y < maze.size(); ++y) {
-    for (int x = 0; x < maze[0].size(); ++x) {
-      maze[y][x] = WALL;
+  maze.fill(WALL);
+  sink.reset(maze);
+  // Initialize the starting point
+  int x = 1 + random.below(maze.width() / 2) * 2;
+  int y = 1 + random.below(maze.height() / 2) * 2;
+
+  // Open the starting point, or a later step carves into it again and
+  // closes a loop
+  maze.set(x, y, EMPTY);
+  sink.cell(x, y, EMPTY);
+
+  // Carved cells, one bit per cell at (x / 2, y / 2). The bitmap is small
+  // enough to stay in cache where the maze is not, and its border reads as
+  // carved, so the four neighbours need no bounds checks.
+  Bitmap carved(maze.width() / 2, maze.height() / 2, false, true);
+  int cell = carved.index(x / 2, y / 2);
+  carved.set(cell);
+  int cellStep[4];
+  int mazeStep[4];
+  for (int k = 0; k < 4; ++k) {
+    cellStep[k] = dx[k] + dy[k] * carved.stride();
+    mazeStep[k] = dx[k] + dy[k] * maze.stride();
+  }
+  int index = maze.index(x, y);
+
+  // The way back to the start, as the direction of every step taken (2 bits
+  // each, 32 per word). Backtracking undoes the last step, so no coordinates
+  // are stored, and the path can never be longer than the number of cells.
+  std::vector<std::uint64_t> path(
+      static_cast<size_t>(carved.width()) * carved.height() / 32 + 1);
+  long depth = 0;
+
+  for (;;) {
+    // Uncarved neighbours, as a mask over the four directions
+    unsigned open = (!carved.test(cell + cellStep[0])) |
+                    (!carved.test(cell + cellStep[1])) << 1 |
+                    (!carved.test(cell + cellStep[2])) << 2 |
+                    (!carved.test(cell + cellStep[3])) << 3;
+    if (open == 0) {
+      // Dead end: step back the way we came, or stop at the start
+      if (depth == 0)
+        break;
+      --depth;
+      int k = (path[depth >> 5] >> ((depth & 31) * 2)) & 3;
+      cell -= cellStep[k];
+      index -= 2 * mazeStep[k];
+      continue;
+    }
+
+    // Randomly select a neighbor
+    int k = nthDirection[open][random.below(directionCount[open])];
+
+    // Remove the wall between the current cell and the selected neighbor
+    maze.set(index + mazeStep[k], EMPTY);
+    index += 2 * mazeStep[k];
+    maze.set(index, EMPTY);
+    cell += cellStep[k];
+    carved.set(cell);
+    if (sink.active()) {
+      sink.cell(maze.xOf(index), maze.yOf(index), EMPTY);
+      sink.cell(maze.xOf(index - mazeStep[k]), maze.yOf(index - mazeStep[k]),
+                EMPTY);
+      sink.step();
     }
+
+    std::uint64_t &word = path[depth >> 5];
+    int shift = (depth & 31) * 2;
+    word = (word & ~(std::uint64_t(3) << shift)) | std::uint64_t(k) << shift;
+    ++depth;
   }
-  // Initialize the starting point
-  int startX = 1 + rand() % (maze[0].size() / 2) * 2;
-  int startY = 1 + rand() % (maze.size() / 2) * 2;
+}
 
-  // Initialize the stack with the starting point
-  std::stack<std::pair<int, int> > stack;
-  stack.push(std::make_pair(startX, startY));
+EllerRows::EllerRows(int width, MazeRandom &random)
+    : width_(width | 1), columns(width_ / 2), random(random),
+      label(columns), parent(columns), seen(columns), pick(columns),
+      remap(columns), down(columns) {
+  // The first row starts with every cell in a set of its own
+  for (int c = 0; c < columns; ++c)
+    label[c] = c;
+}
 
-  while (!stack.empty()) {
-    int x = stack.top().first;
-    int y = stack.top().second;
-    stack.pop();
-
-    std::vector<std::pair<int, int> > neighbors =
-        getUnvisitedNeighbors(x, y, maze);
-    if (!neighbors.empty()) {
-      stack.push(std::make_pair(x, y));
-
-      // Randomly select a neighbor
-      int nextIndex = rand() % neighbors.size();
-      int nx = neighbors[nextIndex].first;
-      int ny = neighbors[nextIndex].second;
-
-      // Remove the wall between the current cell and the selected neighbor
-      maze[ny][nx] = EMPTY;
-      maze[y + (ny - y) / 2][x + (nx - x) / 2] = EMPTY;
-      renderMaze(maze);
-
-      stack.push(std::make_pair(nx, ny));
+int EllerRows::root(int set) {
+  while (parent[set] != set) {
+    parent[set] = parent[parent[set]];
+    set = parent[set];
+  }
+  return set;
+}
+
+void EllerRows::next(char *cells, char *below, bool last) {
+  std::fill(cells, cells + width_, WALL);
+  std::fill(below, below + width_, WALL);
+  // Set numbers are always below columns, so they index the arrays directly
+  for (int c = 0; c < columns; ++c) {
+    parent[label[c]] = label[c];
+    cells[2 * c + 1] = EMPTY;
+  }
+
+  // Join neighbours from different sets: at random, or all of them in the
+  // last row so that no set stays cut off
+  for (int c = 0; c + 1 < columns; ++c) {
+    int left = root(label[c]);
+    int right = root(label[c + 1]);
+    if (left != right && (last || random.coin())) {
+      parent[right] = left;
+      cells[2 * c + 2] = EMPTY;
+    }
+  }
+  if (last)
+    return;
+
+  // Open cells downwards at random, but at least one of every set, or the
+  // set would be cut off from the rest of the maze. For a set without a
+  // random opening, one of its columns is drawn by reservoir sampling while
+  // passing (pick -2 marks sets that already have one).
+  for (int c = 0; c < columns; ++c) {
+    label[c] = root(label[c]);
+    seen[label[c]] = 0;
+    pick[label[c]] = -1;
+  }
+  for (int c = 0; c < columns; ++c) {
+    int set = label[c];
+    down[c] = random.coin();
+    if (down[c])
+      pick[set] = -2;
+    else if (pick[set] != -2 && random.below(++seen[set]) == 0)
+      pick[set] = c;
+  }
+
+  // Cells opened downwards carry their set into the next row, renumbered
+  // from 0; all other cells of the next row start a set of their own
+  std::fill(remap.begin(), remap.end(), -1);
+  int sets = 0;
+  for (int c = 0; c < columns; ++c) {
+    if (pick[label[c]] == c)
+      down[c] = true;
+    if (down[c]) {
+      below[2 * c + 1] = EMPTY;
+      if (remap[label[c]] < 0)
+        remap[label[c]] = sets++;
+    }
+  }
+  for (int c = 0; c < columns; ++c)
+    label[c] = down[c] ? remap[label[c]] : sets++;
+}
+
+// Function to copy the openings of one carved row into row y of the maze
+template <class Maze>
+static void carveRow(Maze &maze, int y, const char *row, MazeSink &sink) {
+  for (int x = 1; x < maze.width() - 1; ++x) {
+    if (row[x] != WALL) {
+      maze.set(x, y, EMPTY);
+      sink.cell(x, y, EMPTY);
+    }
+  }
+}
+
+template <class Maze>
+void carveEllers(Maze &maze, MazeRandom &random, MazeSink &sink) {
+  // Initialize the maze with walls
+  maze.fill(WALL);
+  sink.reset(maze);
+
+  EllerRows rows(maze.width(), random);
+  std::vector<char> cells(rows.width());
+  std::vector<char> below(rows.width());
+  for (int y = 1; y < maze.height() - 1; y += 2) {
+    bool last = y + 2 >= maze.height() - 1;
+    rows.next(cells.data(), below.data(), last);
+    carveRow(maze, y, cells.data(), sink);
+    if (!last)
+      carveRow(maze, y + 1, below.data(), sink);
+    sink.step();
+  }
+}
+
+// Function to pick a random direction (index into dx, dy) that stays on the
+// columns x rows cells of a maze; there must be at least two cells
+static int randomStep(MazeRandom &random, int x, int y, int columns,
+                      int rows) {
+  for (;;) {
+    int k = random.below(4);
+    int nx = x + dx[k];
+    int ny = y + dy[k];
+    if (nx >= 0 && nx < columns && ny >= 0 && ny < rows)
+      return k;
+  }
+}
+
+template <class Maze>
+void carveWilsons(Maze &maze, MazeRandom &random, MazeSink &sink) {
+  // Initialize the maze with walls
+  maze.fill(WALL);
+  sink.reset(maze);
+
+  // Walks run over cells (x / 2, y / 2); the maze starts as one random cell
+  int columns = maze.width() / 2;
+  int rows = maze.height() / 2;
+  Bitmap inMaze(columns, rows);
+  int first = random.below(columns * rows);
+  inMaze.set(inMaze.index(first % columns, first / columns));
+  maze.set(first % columns * 2 + 1, first / columns * 2 + 1, EMPTY);
+  sink.cell(first % columns * 2 + 1, first / columns * 2 + 1, EMPTY);
+
+  // Direction in which a walk last left each cell. Keeping only the last
+  // one erases the loops of the walk: following them from the start leads
+  // straight to where the walk hit the maze.
+  std::vector<unsigned char> exits(static_cast<size_t>(columns) * rows);
+  for (int start = 0; start < columns * rows; ++start) {
+    int x = start % columns;
+    int y = start / columns;
+    if (inMaze.test(x, y))
+      continue;
+
+    // Walk at random until the maze is hit
+    while (!inMaze.test(x, y)) {
+      int k = randomStep(random, x, y, columns, rows);
+      exits[y * columns + x] = k;
+      x += dx[k];
+      y += dy[k];
     }
+
+    // Add the loop-erased path to the maze
+    x = start % columns;
+    y = start / columns;
+    while (!inMaze.test(x, y)) {
+      int k = exits[y * columns + x];
+      inMaze.set(inMaze.index(x, y));
+      maze.set(2 * x + 1, 2 * y + 1, EMPTY);
+      maze.set(2 * x + 1 + dx[k], 2 * y + 1 + dy[k], EMPTY);
+      sink.cell(2 * x + 1, 2 * y + 1, EMPTY);
+      sink.cell(2 * x + 1 + dx[k], 2 * y + 1 + dy[k], EMPTY);
+      x += dx[k];
+      y += dy[k];
+    }
+    sink.step();
+  }
+}
+
+template <class Maze>
+void carveAldousBroder(Maze &maze, MazeRandom &random, MazeSink &sink) {
+  // Initialize the maze with walls
+  maze.fill(WALL);
+  sink.reset(maze);
+
+  // One walk over cells (x / 2, y / 2) that carves into every cell it
+  // enters for the first time, until none is left
+  int columns = maze.width() / 2;
+  int rows = maze.height() / 2;
+  Bitmap visited(columns, rows);
+  int x = random.below(columns);
+  int y = random.below(rows);
+  visited.set(visited.index(x, y));
+  maze.set(2 * x + 1, 2 * y + 1, EMPTY);
+  sink.cell(2 * x + 1, 2 * y + 1, EMPTY);
+
+  for (long remaining = static_cast<long>(columns) * rows - 1; remaining > 0;) {
+    int k = randomStep(random, x, y, columns, rows);
+    x += dx[k];
+    y += dy[k];
+    if (visited.test(x, y))
+      continue;
+
+    visited.set(visited.index(x, y));
+    maze.set(2 * x + 1, 2 * y + 1, EMPTY);
+    maze.set(2 * x + 1 - dx[k], 2 * y + 1 - dy[k], EMPTY);
+    sink.cell(2 * x + 1, 2 * y + 1, EMPTY);
+    sink.cell(2 * x + 1 - dx[k], 2 * y + 1 - dy[k], EMPTY);
+    sink.step();
+    --remaining;
   }
 }
 
-std::vector<std::vector<char> >
-generateMaze(int width = 21, int height = 21,
-             std::function<void(std::vector<std::vector<char> > &)> carveMaze =
-                 randomizedDFS) {
-  srand(time(nullptr)); // Seed for random number generation
+void randomizedKruskals(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveKruskals(maze, random, sink);
+}
+void randomizedKruskals(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carveKruskals(maze, random, sink);
+}
+void recursiveDivision(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveDivision(maze, random, sink);
+}
+void recursiveDivision(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carveDivision(maze, random, sink);
+}
+void randomizedPrims(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carvePrims(maze, random, sink);
+}
+void randomizedPrims(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carvePrims(maze, random, sink);
+}
+void randomizedDFS(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveDFS(maze, random, sink);
+}
+void randomizedDFS(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carveDFS(maze, random, sink);
+}
+
+void randomizedEllers(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveEllers(maze, random, sink);
+}
+void randomizedEllers(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carveEllers(maze, random, sink);
+}
+void randomizedWilsons(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveWilsons(maze, random, sink);
+}
+void randomizedWilsons(BitMaze &maze, MazeRandom &random, MazeSink &sink) {
+  carveWilsons(maze, random, sink);
+}
+void randomizedAldousBroder(Grid &maze, MazeRandom &random, MazeSink &sink) {
+  carveAldousBroder(maze, random, sink);
+}
+void randomizedAldousBroder(BitMaze &maze, MazeRandom &random,
+                            MazeSink &sink) {
+  carveAldousBroder(maze, random, sink);
+}
+
+Grid generateMaze(int width, int height,
+                  void (*carveMaze)(Grid &, MazeRandom &, MazeSink &),
+                  MazeSink &sink, std::uint64_t seed) {
+  // Every call carves with its own generator, so equal seeds give equal
+  // mazes and calls on different threads do not interfere
+  MazeRandom random(seed);
 
   // Ensure odd dimensions
   width |= 1;
   height |= 1;
+  // Below 3 there is no cell inside the border to carve
+  if (width < 3 || height < 3)
+    return Grid();
 
   // Initialize maze with walls
-  std::vector<std::vector<char> > maze(height, std::vector<char>(width, WALL));
+  Grid maze(width, height, WALL);
+
+  carveMaze(maze, random, sink);
+
+  return maze;
+}
+
+BitMaze generateBitMaze(int width, int height,
+                        void (*carveMaze)(BitMaze &, MazeRandom &, MazeSink &),
+                        MazeSink &sink, std::uint64_t seed) {
+  MazeRandom random(seed);
+
+  // Ensure odd dimensions
+  width |= 1;
+  height |= 1;
+  if (width < 3 || height < 3)
+    return BitMaze();
+
+  BitMaze maze(width, height, WALL);
 
-  carveMaze(maze);
+  carveMaze(maze, random, sink);
 
   return maze;
 }
 
 // #include <iostream>
 // int main() {
-//   std::vector<std::vector<char> > maze =
-//       generateMaze(48, 41, randomizedKruskals);
+//   Grid maze = generateMaze(48, 41, randomizedKruskals);
 //   std::cout << "Maze generated!" << std::endl;
-//   std::cout << maze.size() << "x" << maze[0].size() << std::endl;
+//   std::cout << maze.height() << "x" << maze.width() << std::endl;
 
 //   return 0;
 // }
@@ -1,8 +1,12 @@
 #ifndef MAZE_GENERATORS_H
 #define MAZE_GENERATORS_H
 
+#include "bitmaze.h"
+#include "grid.h"
+#include "random.h"
+#include "sink.h"
+#include <cstdint>
 #include <vector>
-#include <functional>
 
 // Union-Find class for Kruskal's algorithm
 class UnionFind {
@@ -16,15 +20,71 @@ private:
     std::vector<int> rank;
 };
 
-// Function prototypes for maze generation algorithms
-void randomizedKruskals(std::vector<std::vector<char> >& maze);
-void recursiveDivision(std::vector<std::vector<char> >& maze);
-void randomizedPrims(std::vector<std::vector<char> >& maze);
-void randomizedDFS(std::vector<std::vector<char> >& maze);
+// Eller's algorithm, one row of cells at a time: a maze of width columns is
+// produced top to bottom while only O(width) state is kept, so mazes of any
+// height can be carved (and written out, see stream.h) without holding
+// them. Every call to next() yields one row of cells and the row of walls
+// below it; the row passed as last joins every remaining set, which closes
+// the maze into a perfect one.
+class EllerRows {
+public:
+  // width is the width of the whole maze, border included (made odd)
+  EllerRows(int width, MazeRandom &random);
+
+  int width() const { return width_; }
+  // Function to carve the next row of cells into cells and the walls below
+  // it into below (width() chars each, border columns included)
+  void next(char *cells, char *below, bool last);
+
+private:
+  int root(int set);
+
+  int width_;
+  int columns; // cells per row
+  MazeRandom &random;
+  std::vector<int> label;  // set of every column in the current row
+  std::vector<int> parent; // union-find over the sets of the current row
+  std::vector<int> seen;   // columns of each set seen so far in this row
+  std::vector<int> pick;   // column chosen to carry the set downwards
+  std::vector<int> remap;  // set number in the next row, -1 if none yet
+  std::vector<char> down;  // whether the column opens downwards
+};
+
+// Function prototypes for maze generation algorithms. Every random choice
+// is drawn from random (see random.h), so a maze depends on its seed only.
+// The maze must have odd dimensions of at least 3 (generateMaze sees to it).
+void randomizedKruskals(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void recursiveDivision(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedPrims(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedDFS(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+// Eller's algorithm (row by row, see EllerRows), Wilson's algorithm (loop-
+// erased random walks, a uniformly random perfect maze) and Aldous-Broder
+// (one random walk, also uniform but slow to cover large mazes)
+void randomizedEllers(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedWilsons(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedAldousBroder(Grid& maze, MazeRandom &random, MazeSink &sink = nullSink());
+
+// The same algorithms carving straight into wall bits
+void randomizedKruskals(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void recursiveDivision(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedPrims(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedDFS(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedEllers(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedWilsons(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
+void randomizedAldousBroder(BitMaze& maze, MazeRandom &random, MazeSink &sink = nullSink());
 
 
 // Generic maze generation function
-std::vector<std::vector<char> > generateMaze(int width = 29, int height = 21,
-             std::function<void(std::vector<std::vector<char> > &)> carveMaze = randomizedDFS);
+// Carving steps are reported to sink (nothing is drawn by default). The same
+// seed and dimensions always give the same maze; without one, a fresh seed
+// is drawn. Even dimensions are rounded up to odd ones; a width or height
+// below 2 leaves no cell to carve and gives an empty maze.
+Grid generateMaze(int width = 29, int height = 21,
+             void (*carveMaze)(Grid &, MazeRandom &, MazeSink &) = randomizedDFS,
+             MazeSink &sink = nullSink(), std::uint64_t seed = randomSeed());
+// Generic maze generation function for bit-packed mazes
+BitMaze generateBitMaze(int width, int height,
+             void (*carveMaze)(BitMaze &, MazeRandom &, MazeSink &) = randomizedDFS,
+             MazeSink &sink = nullSink(), std::uint64_t seed = randomSeed());
 
 #endif // MAZE_GENERATORS_H
@@ -0,0 +1,433 @@
+#include "graph.h"
+#include "definitions.h"
+#include "searchstate.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+// Directions: E, W, S, N; direction ^ 1 is the opposite one
+static int offset(const BitMaze &maze, int direction) {
+  static const int steps[4] = {1, -1, 0, 0};
+  return direction < 2 ? steps[direction]
+                       : (direction == 2 ? maze.stride() : -maze.stride());
+}
+
+JunctionGraph::JunctionGraph(const Grid &maze) : maze_(toBitMaze(maze)) {
+  build();
+}
+JunctionGraph::JunctionGraph(const BitMaze &maze) : maze_(maze) { build(); }
+
+int JunctionGraph::nodeAt(int cell) const {
+  std::vector<int>::const_iterator it =
+      std::lower_bound(nodeCell.begin(), nodeCell.end(), cell);
+  return it != nodeCell.end() && *it == cell ? it - nodeCell.begin() : -1;
+}
+
+int JunctionGraph::walk(int cell, int direction, int limit, int stop, int &end,
+                        std::vector<int> *path) const {
+  int offsets[4] = {offset(maze_, 0), offset(maze_, 1), offset(maze_, 2),
+                    offset(maze_, 3)};
+  int steps = 0;
+  while (steps < limit) {
+    cell += offsets[direction];
+    ++steps;
+    if (path)
+      path->push_back(cell);
+    if (cell == stop || nodes.test(cell))
+      break;
+    // A corridor cell has exactly two open neighbours: go on through the one
+    // we did not come from
+    int back = direction ^ 1;
+    for (int d = 0; d < 4; ++d) {
+      if (d != back && maze_[cell + offsets[d]] != WALL) {
+        direction = d;
+        break;
+      }
+    }
+  }
+  end = cell;
+  return steps;
+}
+
+void JunctionGraph::build() {
+  int width = maze_.width();
+  int height = maze_.height();
+  int offsets[4] = {offset(maze_, 0), offset(maze_, 1), offset(maze_, 2),
+                    offset(maze_, 3)};
+  nodes = Bitmap(width, height);
+  openCells_ = 0;
+
+  // Nodes: open cells that do not continue a corridor
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int cell = maze_.index(x, y);
+      if (maze_[cell] == WALL)
+        continue;
+      ++openCells_;
+      int degree = 0;
+      for (int d = 0; d < 4; ++d)
+        degree += maze_[cell + offsets[d]] != WALL;
+      if (degree != 2) {
+        nodes.set(cell);
+        nodeCell.push_back(cell);
+      }
+    }
+  }
+
+  // Corridors that close on themselves have no node yet: every corridor cell
+  // not reached from a node belongs to one, and becomes its node
+  Bitmap walked(width, height);
+  std::vector<int> corridor;
+  int end;
+  for (int cell : nodeCell) {
+    for (int d = 0; d < 4; ++d) {
+      if (maze_[cell + offsets[d]] == WALL)
+        continue;
+      corridor.clear();
+      walk(cell, d, INT_MAX, -1, end, &corridor);
+      for (int c : corridor)
+        walked.set(c);
+    }
+  }
+  size_t junctions = nodeCell.size();
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int cell = maze_.index(x, y);
+      if (maze_[cell] == WALL || nodes.test(cell) || walked.test(cell))
+        continue;
+      nodes.set(cell);
+      nodeCell.push_back(cell);
+      int d = 0;
+      while (maze_[cell + offsets[d]] == WALL)
+        ++d;
+      corridor.clear();
+      walk(cell, d, INT_MAX, -1, end, &corridor);
+      for (int c : corridor)
+        walked.set(c);
+    }
+  }
+  if (nodeCell.size() != junctions)
+    std::sort(nodeCell.begin(), nodeCell.end());
+
+  // Edges, grouped by source node
+  edgeStart.assign(nodeCell.size() + 1, 0);
+  for (size_t node = 0; node < nodeCell.size(); ++node) {
+    edgeStart[node] = edgeTarget.size();
+    int cell = nodeCell[node];
+    for (int d = 0; d < 4; ++d) {
+      if (maze_[cell + offsets[d]] == WALL)
+        continue;
+      int steps = walk(cell, d, INT_MAX, -1, end);
+      edgeSource.push_back(node);
+      edgeTarget.push_back(nodeAt(end));
+      edgeSteps.push_back(steps);
+      edgeHeading.push_back(d);
+    }
+  }
+  edgeStart[nodeCell.size()] = edgeTarget.size();
+}
+
+template <class Maze>
+static long fillMazeDeadEnds(Maze &maze,
+                             const std::vector<std::pair<int, int> > &keep) {
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+  std::vector<int> kept;
+  for (const std::pair<int, int> &cell : keep)
+    kept.push_back(maze.index(cell.first, cell.second));
+  std::sort(kept.begin(), kept.end());
+
+  auto deadEnd = [&](int cell) {
+    if (maze[cell] == WALL ||
+        std::binary_search(kept.begin(), kept.end(), cell))
+      return false;
+    int degree = 0;
+    for (int d = 0; d < 4; ++d)
+      degree += maze[cell + offsets[d]] != WALL;
+    return degree <= 1;
+  };
+
+  std::vector<int> stack;
+  for (int y = 0; y < maze.height(); ++y) {
+    for (int x = 0; x < maze.width(); ++x) {
+      int cell = maze.index(x, y);
+      if (deadEnd(cell))
+        stack.push_back(cell);
+    }
+  }
+
+  // Walling up a dead end can turn its one neighbour into the next one
+  long filled = 0;
+  while (!stack.empty()) {
+    int cell = stack.back();
+    stack.pop_back();
+    if (!deadEnd(cell))
+      continue;
+    maze.set(cell, WALL);
+    ++filled;
+    for (int d = 0; d < 4; ++d) {
+      if (deadEnd(cell + offsets[d]))
+        stack.push_back(cell + offsets[d]);
+    }
+  }
+  return filled;
+}
+
+long fillDeadEnds(Grid &maze, const std::vector<std::pair<int, int> > &keep) {
+  return fillMazeDeadEnds(maze, keep);
+}
+long fillDeadEnds(BitMaze &maze,
+                  const std::vector<std::pair<int, int> > &keep) {
+  return fillMazeDeadEnds(maze, keep);
+}
+
+// An edge of the graph searched by one query
+struct QueryEdge {
+  int from, to;
+  int cell, direction, length; // walk that covers the edge
+  bool reversed;               // whether the walk runs from `to` to `from`
+};
+
+// The junction graph as seen by one query: its nodes plus, when the start
+// or goal lies inside a corridor, an extra node for it (numbers
+// nodeCount() and nodeCount() + 1) tied to the corridor's end nodes by extra
+// edges (numbers from edgeCount() on).
+class QueryGraph {
+public:
+  QueryGraph(const JunctionGraph &graph, int startCell, int goalCell)
+      : graph(graph), startCell(startCell), goalCell(goalCell) {
+    const BitMaze &maze = graph.maze();
+    int nodes = graph.nodeCount();
+    start = graph.nodeAt(startCell);
+    goal = graph.nodeAt(goalCell);
+    bool startInside = start == -1;
+    bool goalInside = goal == -1;
+    if (startInside)
+      start = nodes;
+    if (goalInside)
+      goal = nodes + 1;
+    if (startCell == goalCell) {
+      goal = start;
+      goalInside = false;
+    }
+
+    int end;
+    for (int d = 0; d < 4; ++d) {
+      if (startInside && maze[startCell + offset(maze, d)] != WALL) {
+        int steps = graph.walk(startCell, d, INT_MAX, goalCell, end);
+        int to = end == goalCell ? goal : graph.nodeAt(end);
+        QueryEdge edge = {start, to, startCell, d, steps, false};
+        extra.push_back(edge);
+      }
+      if (goalInside && maze[goalCell + offset(maze, d)] != WALL) {
+        int steps = graph.walk(goalCell, d, INT_MAX, startCell, end);
+        // A corridor shared with a start inside it is covered from the start
+        if (end == startCell && startInside)
+          continue;
+        int from = end == startCell ? start : graph.nodeAt(end);
+        QueryEdge edge = {from, goal, goalCell, d, steps, true};
+        extra.push_back(edge);
+      }
+    }
+  }
+
+  int size() const { return graph.nodeCount() + 2; }
+  int cellOf(int node) const {
+    if (node < graph.nodeCount())
+      return graph.cellOf(node);
+    return node == graph.nodeCount() ? startCell : goalCell;
+  }
+
+  QueryEdge edge(int id) const {
+    if (id >= graph.edgeCount())
+      return extra[id - graph.edgeCount()];
+    QueryEdge edge = {graph.edgeFrom(id),      graph.edgeTo(id),
+                      graph.cellOf(graph.edgeFrom(id)),
+                      graph.edgeDirection(id), graph.edgeLength(id),
+                      false};
+    return edge;
+  }
+
+  // Function to call visit(edge id, target, length) for every edge leaving
+  // node
+  template <class Visit> void forEachEdge(int node, Visit visit) const {
+    if (node < graph.nodeCount()) {
+      for (int e = graph.firstEdge(node); e < graph.firstEdge(node + 1); ++e)
+        visit(e, graph.edgeTo(e), graph.edgeLength(e));
+    }
+    for (size_t k = 0; k < extra.size(); ++k) {
+      if (extra[k].from == node)
+        visit(graph.edgeCount() + k, extra[k].to, extra[k].length);
+    }
+  }
+
+  // Function to rebuild the cell path from the parent edges in state
+  void tracePath(const SearchState &state, SearchResult &result,
+                 MazeSink &sink) const {
+    const BitMaze &maze = graph.maze();
+    std::vector<int> cells(1, goalCell);
+    std::vector<int> corridor;
+    int end;
+    for (int node = goal; state.parent(node) != -1;) {
+      QueryEdge e = edge(state.parent(node));
+      corridor.clear();
+      graph.walk(e.cell, e.direction, e.length, -1, end, &corridor);
+      if (e.reversed) {
+        // Walked from the goal towards e.from
+        cells.insert(cells.end(), corridor.begin(), corridor.end());
+      } else {
+        // Walked from e.from; its last cell is the node already recorded
+        cells.insert(cells.end(), corridor.rbegin() + 1, corridor.rend());
+        cells.push_back(e.cell);
+      }
+      node = e.from;
+    }
+    std::reverse(cells.begin(), cells.end());
+
+    for (int cell : cells) {
+      int x = maze.xOf(cell);
+      int y = maze.yOf(cell);
+      result.path.push_back(std::make_pair(x, y));
+      if (cell != startCell && cell != goalCell) {
+        sink.cell(x, y, PATH);
+        sink.step();
+      }
+    }
+    result.found = true;
+  }
+
+  // Record one expanded node
+  void expand(int node, SearchResult &result, MazeSink &sink) const {
+    result.expanded++;
+    int cell = cellOf(node);
+    if (cell != startCell) {
+      const BitMaze &maze = graph.maze();
+      sink.cell(maze.xOf(cell), maze.yOf(cell), VISITED);
+    }
+    sink.step();
+  }
+
+  const JunctionGraph &graph;
+  int startCell, goalCell;
+  int start, goal; // node numbers
+  std::vector<QueryEdge> extra;
+};
+
+// Dijkstra (heuristic == nullptr) or A* over the nodes of a query graph
+template <class OpenList>
+static SearchResult searchGraph(const JunctionGraph &graph, int startX,
+                                int startY, int goalX, int goalY,
+                                int (*heuristic)(int, int, int, int),
+                                MazeSink &sink, SearchState &state,
+                                OpenList &open) {
+  SearchResult result;
+  const BitMaze &maze = graph.maze();
+  sink.reset(maze);
+  QueryGraph query(graph, maze.index(startX, startY),
+                   maze.index(goalX, goalY));
+
+  auto estimate = [&](int node) {
+    if (!heuristic)
+      return 0;
+    int cell = query.cellOf(node);
+    return heuristic(maze.xOf(cell), maze.yOf(cell), goalX, goalY);
+  };
+
+  state.begin(query.size());
+  open.reset(query.size());
+  state.reach(query.start, 0, -1);
+  open.push(estimate(query.start), query.start);
+
+  while (!open.empty()) {
+    int node = open.pop().index;
+    if (state.closed(node))
+      continue;
+    state.close(node);
+
+    if (node == query.goal) {
+      query.tracePath(state, result, sink);
+      return result;
+    }
+    query.expand(node, result, sink);
+
+    int cost = state.cost(node);
+    query.forEachEdge(node, [&](int edge, int to, int length) {
+      if (state.cost(to) > cost + length) {
+        state.reach(to, cost + length, edge);
+        open.push(cost + length + estimate(to), to);
+      }
+    });
+  }
+  return result; // No path found
+}
+
+static SearchResult searchGraphWith(OpenListType openList,
+                                    const JunctionGraph &graph, int startX,
+                                    int startY, int goalX, int goalY,
+                                    int (*heuristic)(int, int, int, int),
+                                    MazeSink &sink) {
+  SearchState &state = threadSearchState();
+  OpenLists &open = state.open[0];
+  switch (openList) {
+  case OPEN_BINARY_HEAP:
+    return searchGraph(graph, startX, startY, goalX, goalY, heuristic, sink,
+                       state, open.binaryHeap);
+  case OPEN_QUAD_HEAP:
+    return searchGraph(graph, startX, startY, goalX, goalY, heuristic, sink,
+                       state, open.quadHeap);
+  case OPEN_INDEXED_HEAP:
+    return searchGraph(graph, startX, startY, goalX, goalY, heuristic, sink,
+                       state, open.indexedHeap);
+  case OPEN_BUCKET_QUEUE:
+  default:
+    return searchGraph(graph, startX, startY, goalX, goalY, heuristic, sink,
+                       state, open.bucketQueue);
+  }
+}
+
+SearchResult findPathBFS(const JunctionGraph &graph, int startX, int startY,
+                         int goalX, int goalY, MazeSink &sink) {
+  SearchResult result;
+  const BitMaze &maze = graph.maze();
+  sink.reset(maze);
+  QueryGraph query(graph, maze.index(startX, startY),
+                   maze.index(goalX, goalY));
+
+  SearchState &state = threadSearchState();
+  state.begin(query.size());
+  std::vector<int> &queue = state.queue[0];
+  queue.clear();
+  queue.push_back(query.start);
+  state.reach(query.start, 0, -1);
+
+  for (size_t head = 0; head < queue.size(); ++head) {
+    int node = queue[head];
+    if (node == query.goal) {
+      query.tracePath(state, result, sink);
+      return result;
+    }
+    query.expand(node, result, sink);
+
+    query.forEachEdge(node, [&](int edge, int to, int) {
+      if (!state.reached(to)) {
+        state.reach(to, 0, edge);
+        queue.push_back(to);
+      }
+    });
+  }
+  return result; // No path found
+}
+
+SearchResult findPathDijkstra(const JunctionGraph &graph, int startX,
+                              int startY, int goalX, int goalY,
+                              MazeSink &sink, OpenListType openList) {
+  return searchGraphWith(openList, graph, startX, startY, goalX, goalY,
+                         nullptr, sink);
+}
+
+SearchResult findPathAStar(const JunctionGraph &graph, int startX, int startY,
+                           int goalX, int goalY,
+                           int (*heuristic)(int, int, int, int),
+                           MazeSink &sink, OpenListType openList) {
+  return searchGraphWith(openList, graph, startX, startY, goalX, goalY,
+                         heuristic, sink);
+}
@@ -0,0 +1,91 @@
+#ifndef MAZE_GRAPH_H
+#define MAZE_GRAPH_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "openlist.h"
+#include "sink.h"
+#include "solver.h"
+#include <utility>
+#include <vector>
+
+// Corridor contraction: the maze as a sparse graph whose nodes are the cells
+// where corridors meet or end (every open cell without exactly two open
+// neighbours; one cell of any corridor that closes on itself) and whose edges
+// are the corridors between them, weighted by their length in steps. Perfect
+// mazes are mostly 1-wide corridors, so the graph is several times smaller
+// than the maze, and searches on it expand nodes instead of cells. Start and
+// goal may be any open cell: a cell inside a corridor is attached to the two
+// nodes at the corridor's ends for the length of one query.
+//
+// The graph keeps its own copy of the walls, so the source maze may change or
+// go away afterwards.
+class JunctionGraph {
+public:
+  explicit JunctionGraph(const Grid &maze);
+  explicit JunctionGraph(const BitMaze &maze);
+
+  const BitMaze &maze() const { return maze_; }
+  int nodeCount() const { return nodeCell.size(); }
+  // Directed edges; every corridor appears once in each direction
+  int edgeCount() const { return edgeTarget.size(); }
+  // Open cells of the maze, to compare the graph size against
+  long openCells() const { return openCells_; }
+
+  // Node at a maze index, -1 if the cell is not a node
+  int nodeAt(int cell) const;
+  int cellOf(int node) const { return nodeCell[node]; }
+
+  // Outgoing edges of node are firstEdge(node) .. firstEdge(node + 1) - 1
+  int firstEdge(int node) const { return edgeStart[node]; }
+  int edgeTo(int edge) const { return edgeTarget[edge]; }
+  int edgeFrom(int edge) const { return edgeSource[edge]; }
+  int edgeLength(int edge) const { return edgeSteps[edge]; }
+  // Direction (E, W, S, N) of the first step from the source node
+  int edgeDirection(int edge) const { return edgeHeading[edge]; }
+
+  // Function to walk a corridor from cell: the first step goes in direction,
+  // later steps follow the corridor. It stops on a node, after limit steps or
+  // on stop, whichever comes first, and returns the number of steps taken;
+  // the cell reached is stored in end. With path set, every cell after cell
+  // is appended to it.
+  int walk(int cell, int direction, int limit, int stop, int &end,
+           std::vector<int> *path = nullptr) const;
+
+private:
+  void build();
+
+  BitMaze maze_;
+  Bitmap nodes; // set for node cells, indexed like maze_
+  long openCells_;
+  std::vector<int> nodeCell; // maze index of every node, ascending
+  std::vector<int> edgeStart;
+  std::vector<int> edgeSource, edgeTarget, edgeSteps;
+  std::vector<unsigned char> edgeHeading;
+};
+
+// Function to wall up dead ends: every open cell with at most one open
+// neighbour is turned into WALL, repeatedly, except the cells in keep. In a
+// perfect maze with keep = {start, goal} only the path between them remains.
+// Returns the number of cells filled.
+long fillDeadEnds(Grid &maze, const std::vector<std::pair<int, int> > &keep);
+long fillDeadEnds(BitMaze &maze,
+                  const std::vector<std::pair<int, int> > &keep);
+
+// Searches on the junction graph. They report the same SearchResult as the
+// cell searches: the full cell path, but expanded counts graph nodes.
+// Dijkstra and A* find shortest paths in cells; BFS finds the path through
+// the fewest nodes, which is the shortest one only in perfect mazes. The sink
+// sees the expanded nodes and the final path.
+SearchResult findPathBFS(const JunctionGraph &graph, int startX, int startY,
+                         int goalX, int goalY, MazeSink &sink = nullSink());
+SearchResult findPathDijkstra(const JunctionGraph &graph, int startX,
+                              int startY, int goalX, int goalY,
+                              MazeSink &sink = nullSink(),
+                              OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathAStar(
+    const JunctionGraph &graph, int startX, int startY, int goalX, int goalY,
+    int (*heuristic)(int, int, int, int) = defaultHeuristic,
+    MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+
+#endif // MAZE_GRAPH_H
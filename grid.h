@@ -0,0 +1,89 @@
+#ifndef MAZE_GRID_H
+#define MAZE_GRID_H
+
+#include "definitions.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Function to tell whether height rows of stride cells, plus a border row
+// above and below, can be numbered with int indices, as Grid and BitMaze
+// number their cells. This limits mazes to about 46000 x 46000 cells.
+inline bool fitsIndexRange(long long stride, long long height) {
+  return stride >= 0 && height >= 0 &&
+         (height + 2) * stride <= std::numeric_limits<int>::max();
+}
+
+// Function to return the number of such cells. Throws std::length_error if
+// they do not fit, as std::vector does for sizes it cannot hold, so an
+// oversized maze never wraps its indices around.
+inline std::size_t indexedCells(long long stride, long long height) {
+  if (!fitsIndexRange(stride, height))
+    throw std::length_error("maze too large for int cell indices");
+  return static_cast<std::size_t>((height + 2) * stride);
+}
+
+// Maze grid stored as one contiguous row-major buffer. Each row is padded
+// with a sentinel WALL cell on both sides and there is a sentinel row above
+// and below the maze, so every in-maze cell has four valid neighbours at
+// index +1, -1, +stride() and -stride(), and walks need no bounds checks.
+// Cells are addressed either by (x, y) or by their index in the buffer.
+class Grid {
+public:
+  Grid() : width_(0), height_(0), stride_(2), cells(4, WALL) {}
+  Grid(int width, int height, char fill = WALL)
+      : width_(width), height_(height),
+        stride_(static_cast<int>(width + 2LL)),
+        cells(indexedCells(width + 2LL, height), WALL) {
+    this->fill(fill);
+  }
+  // Function to tell whether a width x height grid can be built
+  static bool fits(int width, int height) {
+    return width >= 0 && fitsIndexRange(width + 2LL, height);
+  }
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // Distance between vertically adjacent cells in the buffer
+  int stride() const { return stride_; }
+  // Number of stored cells, sentinel border included
+  int size() const { return cells.size(); }
+  bool empty() const { return width_ == 0 || height_ == 0; }
+
+  // (x, y) <-> index helpers; x and y may be -1 or width/height (border)
+  int index(int x, int y) const { return (y + 1) * stride_ + x + 1; }
+  int xOf(int index) const { return index % stride_ - 1; }
+  int yOf(int index) const { return index / stride_ - 1; }
+  bool contains(int x, int y) const {
+    return x >= 0 && x < width_ && y >= 0 && y < height_;
+  }
+
+  char &operator()(int x, int y) { return cells[index(x, y)]; }
+  char operator()(int x, int y) const { return cells[index(x, y)]; }
+  char &operator[](int index) { return cells[index]; }
+  char operator[](int index) const { return cells[index]; }
+  void set(int index, char value) { cells[index] = value; }
+  void set(int x, int y, char value) { cells[index(x, y)] = value; }
+
+  // Pointer to the first in-maze cell of row y; the row is width() long
+  char *row(int y) { return &cells[index(0, y)]; }
+  const char *row(int y) const { return &cells[index(0, y)]; }
+
+  // Function to set cells first .. last (inclusive) of row y to value
+  void fillRow(int y, int first, int last, char value) {
+    std::fill(row(y) + first, row(y) + last + 1, value);
+  }
+  // Function to set every in-maze cell (not the border) to value
+  void fill(char value) {
+    for (int y = 0; y < height_; ++y)
+      std::fill(row(y), row(y) + width_, value);
+  }
+
+private:
+  int width_, height_, stride_;
+  std::vector<char> cells;
+};
+
+#endif // MAZE_GRID_H
@@ -0,0 +1,64 @@
+#include "jumptable.h"
+#include "definitions.h"
+
+JumpTable::JumpTable(const Grid &maze) { build(maze); }
+JumpTable::JumpTable(const BitMaze &maze) { build(maze); }
+
+template <class Maze> void JumpTable::build(const Maze &maze) {
+  width_ = maze.width();
+  height_ = maze.height();
+  int stride = this->stride();
+  open_.assign((height_ + 2) * stride, 0);
+  jumps.assign(4 * open_.size(), 0);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x)
+      open_[index(x, y)] = maze(x, y) != WALL;
+  }
+
+  // Whether arriving at n with a horizontal step allows a turn that the
+  // cell before it did not
+  auto forced = [&](int n, int step) {
+    return (open_[n + stride] && !open_[n - step + stride]) ||
+           (open_[n - stride] && !open_[n - step - stride]);
+  };
+  // Jump distance from a cell whose neighbour n in the jump direction is
+  // known: 1 if n is a jump point, else one more than n's own distance
+  auto extend = [&](int n, bool stop, int next) {
+    if (!open_[n])
+      return 0;
+    if (stop)
+      return 1;
+    return next > 0 ? next + 1 : next - 1;
+  };
+
+  // Horizontal jumps, each row scanned against the jump direction
+  for (int y = 0; y < height_; ++y) {
+    for (int x = width_ - 1; x >= 0; --x) {
+      int cell = index(x, y);
+      int n = cell + 1;
+      jumps[4 * cell + 0] = extend(n, forced(n, 1), jumps[4 * n + 0]);
+    }
+    for (int x = 0; x < width_; ++x) {
+      int cell = index(x, y);
+      int n = cell - 1;
+      jumps[4 * cell + 1] = extend(n, forced(n, -1), jumps[4 * n + 1]);
+    }
+  }
+  // Vertical jumps stop where either horizontal jump finds a jump point
+  for (int y = height_ - 1; y >= 0; --y) {
+    for (int x = 0; x < width_; ++x) {
+      int cell = index(x, y);
+      int n = cell + stride;
+      bool stop = jumps[4 * n + 0] > 0 || jumps[4 * n + 1] > 0;
+      jumps[4 * cell + 2] = extend(n, stop, jumps[4 * n + 2]);
+    }
+  }
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      int cell = index(x, y);
+      int n = cell - stride;
+      bool stop = jumps[4 * n + 0] > 0 || jumps[4 * n + 1] > 0;
+      jumps[4 * cell + 3] = extend(n, stop, jumps[4 * n + 3]);
+    }
+  }
+}
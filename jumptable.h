@@ -0,0 +1,50 @@
+#ifndef MAZE_JUMPTABLE_H
+#define MAZE_JUMPTABLE_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include <vector>
+
+// Jump distances of one maze for Jump Point Search (JPS+). For every cell and
+// each of the four directions it stores how far a straight jump goes before
+// it reaches a jump point, so a search reads the next jump point instead of
+// scanning for it. The table is laid out like a Grid of the same size
+// (sentinel border, stride width + 2) whatever maze it was built from, and
+// stays valid only as long as the maze's walls do not change.
+//
+// Directions are numbered E, W, S, N as in the solvers. A horizontal jump
+// stops at a cell where a vertical move becomes possible that was not
+// possible one cell earlier (a forced turn); a vertical jump stops at a cell
+// from which a horizontal jump finds a jump point.
+class JumpTable {
+public:
+  explicit JumpTable(const Grid &maze);
+  explicit JumpTable(const BitMaze &maze);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int stride() const { return width_ + 2; }
+  int size() const { return open_.size(); }
+
+  int index(int x, int y) const { return (y + 1) * stride() + x + 1; }
+  int xOf(int index) const { return index % stride() - 1; }
+  int yOf(int index) const { return index / stride() - 1; }
+
+  // Whether a cell is not a wall
+  bool open(int index) const { return open_[index] != 0; }
+  // Steps from index in direction to the next jump point when positive;
+  // otherwise the jump finds none and -jump(...) open cells follow before a
+  // wall
+  int jump(int index, int direction) const {
+    return jumps[4 * index + direction];
+  }
+
+private:
+  template <class Maze> void build(const Maze &maze);
+
+  int width_, height_;
+  std::vector<unsigned char> open_;
+  std::vector<int> jumps; // four entries per cell, in direction order
+};
+
+#endif // MAZE_JUMPTABLE_H
@@ -1,9 +1,25 @@
+#include "bitbfs.h"
 #include "definitions.h"
+#include "engine.h"
 #include "generator.h"
+#include "grid.h"
+#include "mazefile.h"
+#include "parallelbfs.h"
+#include "random.h"
+#include "sink.h"
+#include "stream.h"
 #include "solver.h"
+#include "threadpool.h"
 #include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -48,9 +64,272 @@ void takeDimensions(int &width, int &height) {
   }
 }
 
-int main() {
+void printUsage(const char *program) {
+  std::cout << "Usage: " << program << " [--headless] [options]\n"
+            << "  --headless            generate and solve without rendering\n"
+            << "  --width N             maze width (odd, default 29)\n"
+            << "  --height N            maze height (odd, default 21)\n"
+            << "  --generator NAME      dfs | prims | division | kruskals |\n"
+            << "                        ellers | wilsons | aldousbroder\n"
+            << "  --seed N              generate the same maze again (default:\n"
+            << "                        random; the run prints its seed)\n"
+            << "  --solver NAME         dfs | bfs | dijkstra | astar | bibfs |\n"
+            << "                        biastar | jps | jpsplus | tree |\n"
+            << "                        bitbfs | pbfs\n"
+            << "  --open-list NAME      binary | quad | bucket | indexed\n"
+            << "                        (Dijkstra, A* and JPS only, default bucket)\n"
+            << "  --fill-dead-ends      wall up dead ends before solving\n"
+            << "  --contract            search the junction graph of corridors\n"
+            << "                        (bfs, dijkstra and astar only)\n"
+            << "  --print               print the solved maze\n"
+            << "  --stream FILE         write an ellers maze to FILE (- for\n"
+            << "                        stdout) row by row, without solving\n"
+            << "  --convert IN OUT      convert a text maze to the binary format\n"
+            << "                        or back (see mazefile.h)\n"
+            << "  --queries N           also solve N random queries as a batch\n"
+            << "  --threads N           worker threads for --queries and --scaling\n"
+            << "                        (default: one per hardware thread)\n"
+            << "  --scaling             time the parallel BFS on 1, 2, 4, ...\n"
+            << "                        threads up to --threads\n"
+            << "Without arguments the interactive visualizer is started."
+            << std::endl;
+}
+
+// Function to time the parallel BFS between the corners of maze on pools of
+// 1, 2, 4, ... threads up to maxThreads, with the speedup over one thread
+void reportScaling(const Grid &maze, int maxThreads) {
+  typedef std::chrono::steady_clock Clock;
+  int goalX = maze.width() - 2;
+  int goalY = maze.height() - 2;
+  double baseMillis = 0;
+  for (int threads = 1;; threads *= 2) {
+    if (threads > maxThreads)
+      threads = maxThreads;
+    ThreadPool pool(threads);
+    Clock::time_point t0 = Clock::now();
+    findPathParallelBFS(maze, 1, 1, goalX, goalY, pool);
+    Clock::time_point t1 = Clock::now();
+    double millis = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    if (threads == 1)
+      baseMillis = millis;
+    std::cout << "scaling threads=" << threads << " ms=" << millis
+              << " speedup=" << baseMillis / millis << std::endl;
+    if (threads == maxThreads)
+      break;
+  }
+}
+
+// Function to stream a maze into a file (or stdout for "-") as it is
+// generated; only Eller's algorithm works row by row
+int streamToFile(const std::string &filename, int width, int height,
+                 std::uint64_t seed) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point t0 = Clock::now();
+  bool written;
+  if (filename == "-") {
+    written = streamMaze(std::cout, width, height, seed);
+  } else {
+    std::ofstream file(filename, std::ios::binary);
+    written = file.is_open() && streamMaze(file, width, height, seed);
+  }
+  Clock::time_point t1 = Clock::now();
+  if (!written) {
+    std::cerr << "Failed to write " << filename << std::endl;
+    return 1;
+  }
+  // Statistics go to stderr so they never mix with a maze on stdout
+  std::cerr << "generator=ellers width=" << (width | 1)
+            << " height=" << (height | 1) << " seed=" << seed
+            << " stream_ms="
+            << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << std::endl;
+  return 0;
+}
+
+// Function to convert a maze file between text and binary and time it
+int convertFile(const std::string &input, const std::string &output) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point t0 = Clock::now();
+  if (!convertMaze(input, output))
+    return 1;
+  Clock::time_point t1 = Clock::now();
+  std::cout << "converted " << input << " -> " << output << " convert_ms="
+            << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << std::endl;
+  return 0;
+}
+
+// Headless mode: parse the command line, run the engine and report stats
+int runCommandLine(int argc, char *argv[]) {
+  int width = 29;
+  int height = 21;
+  GeneratorType generator = GENERATOR_DFS;
+  SolverType solver = SOLVER_DFS;
+  std::string generatorName = "dfs";
+  std::string solverName = "dfs";
+  OpenListType openList = OPEN_BUCKET_QUEUE;
+  std::string openListName = "bucket";
+  bool headless = false;
+  bool print = false;
+  PreprocessOptions preprocess;
+  int queries = 0;
+  int threads = 0;
+  bool scaling = false;
+  std::uint64_t seed = randomSeed();
+  std::string streamFile; // empty: solve as usual
+  std::string convertInput, convertOutput;
+  bool generatorGiven = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(arg, "--headless") == 0) {
+      headless = true;
+    } else if (std::strcmp(arg, "--print") == 0) {
+      print = true;
+    } else if (std::strcmp(arg, "--fill-dead-ends") == 0) {
+      preprocess.fillDeadEnds = true;
+    } else if (std::strcmp(arg, "--contract") == 0) {
+      preprocess.contract = true;
+    } else if (std::strcmp(arg, "--scaling") == 0) {
+      scaling = true;
+    } else if (std::strcmp(arg, "--width") == 0 && hasValue) {
+      width = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--height") == 0 && hasValue) {
+      height = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--stream") == 0 && hasValue) {
+      streamFile = argv[++i];
+    } else if (std::strcmp(arg, "--convert") == 0 && i + 2 < argc) {
+      convertInput = argv[++i];
+      convertOutput = argv[++i];
+    } else if (std::strcmp(arg, "--queries") == 0 && hasValue) {
+      queries = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+      threads = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--generator") == 0 && hasValue) {
+      generatorName = argv[++i];
+      generatorGiven = true;
+      if (!parseGeneratorType(generatorName, generator)) {
+        std::cerr << "Unknown generator: " << generatorName << std::endl;
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--solver") == 0 && hasValue) {
+      solverName = argv[++i];
+      if (!parseSolverType(solverName, solver)) {
+        std::cerr << "Unknown solver: " << solverName << std::endl;
+        return 1;
+      }
+    } else if (std::strcmp(arg, "--open-list") == 0 && hasValue) {
+      openListName = argv[++i];
+      if (!parseOpenListType(openListName, openList)) {
+        std::cerr << "Unknown open list: " << openListName << std::endl;
+        return 1;
+      }
+    } else {
+      printUsage(argv[0]);
+      return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if (!headless) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (!convertInput.empty())
+    return convertFile(convertInput, convertOutput);
+  if (width < 5 || height < 5) {
+    std::cerr << "Dimensions too small." << std::endl;
+    return 1;
+  }
+  if (streamFile.empty() && !Grid::fits(width | 1, height | 1)) {
+    // Streaming holds a few rows only, so it has no such limit
+    std::cerr << "Dimensions too large (about 46000 x 46000 cells at most)."
+              << std::endl;
+    return 1;
+  }
+  if (!streamFile.empty()) {
+    if (generatorGiven && generator != GENERATOR_ELLERS) {
+      std::cerr << "--stream works with the ellers generator only."
+                << std::endl;
+      return 1;
+    }
+    return streamToFile(streamFile, width, height, seed);
+  }
+  if (preprocess.contract && !supportsContraction(solver)) {
+    std::cerr << "--contract works with bfs, dijkstra and astar only."
+              << std::endl;
+    return 1;
+  }
+
+  EngineResult run =
+      runHeadless(width, height, generator, solver, openList, preprocess, seed);
+
+  if (print) {
+    for (int y = 0; y < run.maze.height(); ++y) {
+      std::cout.write(run.maze.row(y), run.maze.width());
+      std::cout << '\n';
+    }
+  }
+  std::cout << "generator=" << generatorName << " solver=" << solverName
+            << " open_list=" << openListName
+            << " width=" << run.maze.width() << " height=" << run.maze.height()
+            << " seed=" << run.seed << "\n"
+            << "generate_ms=" << run.generateMillis
+            << " solve_ms=" << run.solveMillis << "\n";
+  if (preprocess.fillDeadEnds || preprocess.contract) {
+    std::cout << "preprocess_ms=" << run.preprocessMillis
+              << " filled=" << run.filledCells
+              << " open_cells=" << run.openCells;
+    if (preprocess.contract)
+      std::cout << " graph_nodes=" << run.graphNodes
+                << " graph_edges=" << run.graphEdges;
+    std::cout << "\n";
+  }
+  std::cout
+            << "found=" << run.search.found
+            << " path_length="
+            << (run.search.found ? run.search.path.size() - 1 : 0)
+            << " expanded=" << run.search.expanded << std::endl;
+
+  if (queries > 0) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<PathQuery> batch = randomQueries(run.maze, queries);
+    ThreadPool pool(threads);
+    Clock::time_point t0 = Clock::now();
+    std::vector<SearchResult> results =
+        solveBatch(solver, run.maze, batch, pool, openList);
+    Clock::time_point t1 = Clock::now();
+
+    int found = 0;
+    long totalLength = 0;
+    for (const SearchResult &result : results) {
+      if (result.found) {
+        ++found;
+        totalLength += result.path.size() - 1;
+      }
+    }
+    std::cout << "queries=" << queries << " threads=" << pool.size()
+              << " batch_ms="
+              << std::chrono::duration<double, std::milli>(t1 - t0).count()
+              << " found=" << found << " total_path_length=" << totalLength
+              << std::endl;
+  }
+  if (scaling) {
+    if (threads <= 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    reportScaling(run.maze, threads);
+  }
+  return run.search.found ? 0 : 2;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1)
+    return runCommandLine(argc, argv);
+
   // Load the maze
-  std::vector<std::vector<char>> maze = loadMaze("cpp_logo.txt");
+  Grid maze = loadMaze("cpp_logo.txt");
 
   // Clear screen and print the initial maze
   clearScreen();
@@ -72,72 +351,125 @@ int main() {
   std::cout << "2. Randomized Prim's Algorithm" << std::endl;
   std::cout << "3. Recursive Division" << std::endl;
   std::cout << "4. Randomized Kruskal's Algorithm" << std::endl;
+  std::cout << "5. Eller's Algorithm" << std::endl;
+  std::cout << "6. Wilson's Algorithm" << std::endl;
+  std::cout << "7. Aldous-Broder Algorithm" << std::endl;
   std::cout << "Choose an algorithm to generate the maze:" << std::endl;
   int choice;
   std::cin >> choice;
 
+  // Every generation and solving step is drawn on the terminal
+  TerminalSink terminal;
+
   // Attempt to generate a maze using the selected algorithm
   switch (choice) {
   case 1:
-    maze = generateMaze(width, height, randomizedDFS);
+    maze = generateMaze(width, height, randomizedDFS, terminal);
     break;
   case 2:
-    maze = generateMaze(width, height, randomizedPrims);
+    maze = generateMaze(width, height, randomizedPrims, terminal);
     break;
   case 3:
-    maze = generateMaze(width, height, recursiveDivision);
+    maze = generateMaze(width, height, recursiveDivision, terminal);
     break;
   case 4:
-    maze = generateMaze(width, height, randomizedKruskals);
+    maze = generateMaze(width, height, randomizedKruskals, terminal);
+    break;
+  case 5:
+    maze = generateMaze(width, height, randomizedEllers, terminal);
+    break;
+  case 6:
+    maze = generateMaze(width, height, randomizedWilsons, terminal);
+    break;
+  case 7:
+    maze = generateMaze(width, height, randomizedAldousBroder, terminal);
     break;
   default:
     std::cout << "Invalid choice. Using the default algorithm." << std::endl;
     // delay for a few seconds
     std::this_thread::sleep_for(std::chrono::seconds(2));
-    maze = generateMaze(width, height, randomizedDFS);
+    maze = generateMaze(width, height, randomizedDFS, terminal);
     break;
   }
 
+  terminal.flush();
+
   // Prompt the user to choose a maze solver
   std::cout << "1. Depth-First Search" << std::endl;
   std::cout << "2. Breadth-First Search" << std::endl;
   std::cout << "3. Dijkstra Search" << std::endl;
   std::cout << "4. A* Search" << std::endl;
+  std::cout << "5. Bidirectional BFS" << std::endl;
+  std::cout << "6. Bidirectional A* Search" << std::endl;
+  std::cout << "7. Jump Point Search" << std::endl;
+  std::cout << "8. Jump Point Search with precomputed jumps" << std::endl;
+  std::cout << "9. Tree path index" << std::endl;
+  std::cout << "10. Bit-parallel BFS" << std::endl;
+  std::cout << "11. Parallel BFS" << std::endl;
   std::cout << "Choose an algorithm to solver the maze:" << std::endl;
   std::cin >> choice;
 
   // Set the start and goal positions
   int startX = 1;
   int startY = 1;
-  int goalX = maze[0].size() - 2;
-  int goalY = maze.size() - 2;
+  int goalX = maze.width() - 2;
+  int goalY = maze.height() - 2;
 
-  maze[startY][startX] = START;
-  maze[goalY][goalX] = GOAL;
+  maze(startX, startY) = START;
+  maze(goalX, goalY) = GOAL;
 
   // Attempt to find a path using the selected algorithm
-  bool pathFound = false;
+  SearchResult result;
   switch (choice) {
   case 1:
-    pathFound = findPathDFS(maze, startX, startY, goalX, goalY);
+    result = findPathDFS(maze, startX, startY, goalX, goalY, terminal);
     break;
   case 2:
-    pathFound = findPathBFS(maze, startX, startY, goalX, goalY);
+    result = findPathBFS(maze, startX, startY, goalX, goalY, terminal);
     break;
   case 3:
-    pathFound = findPathDijkstra(maze, startX, startY, goalX, goalY);
+    result = findPathDijkstra(maze, startX, startY, goalX, goalY, terminal);
     break;
   case 4:
-    pathFound = findPathAStar(maze, startX, startY, goalX, goalY);
+    result = findPathAStar(maze, startX, startY, goalX, goalY,
+                           defaultHeuristic, terminal);
+    break;
+  case 5:
+    result = findPathBidirectionalBFS(maze, startX, startY, goalX, goalY,
+                                      terminal);
+    break;
+  case 6:
+    result = findPathBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                        defaultHeuristic, terminal);
+    break;
+  case 7:
+    result = findPathJPS(maze, startX, startY, goalX, goalY, defaultHeuristic,
+                         terminal);
+    break;
+  case 8:
+    result = findPathJPS(maze, JumpTable(maze), startX, startY, goalX, goalY,
+                         defaultHeuristic, terminal);
+    break;
+  case 9:
+    result = solveMazeWith(SOLVER_TREE_INDEX, maze, startX, startY, goalX,
+                           goalY, terminal);
+    break;
+  case 10:
+    result = findPathBitBFS(maze, startX, startY, goalX, goalY, terminal);
+    break;
+  case 11:
+    result = solveMazeWith(SOLVER_PARALLEL_BFS, maze, startX, startY, goalX,
+                           goalY, terminal);
     break;
   default:
     std::cout << "Invalid choice. Using the default algorithm." << std::endl;
     // delay for a few seconds
     std::this_thread::sleep_for(std::chrono::seconds(2));
-    pathFound = findPathDFS(maze, startX, startY, goalX, goalY);
+    result = findPathDFS(maze, startX, startY, goalX, goalY, terminal);
     break;
   }
-  if (!pathFound) {
+  terminal.flush();
+  if (!result.found) {
     std::cout << "No path found." << std::endl;
   } else {
     std::cout << "Path found!" << std::endl;
@@ -0,0 +1,412 @@
+#include "mazefile.h"
+#include "definitions.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char BINARY_MAGIC[8] = {'M', 'A', 'Z', 'E', 'B', 'I', 'T', 'S'};
+static const std::int32_t BINARY_VERSION = 1;
+static const std::size_t BINARY_HEADER = 32;
+
+// Text is written in blocks of about this many bytes
+static const std::size_t TEXT_BLOCK = 1 << 20;
+
+// Whole file mapped into memory. Writable mappings are private: pages that
+// are written to are copied, and the file itself never changes. Where mmap
+// is not available the file is read into a buffer instead.
+class MappedFile {
+public:
+  MappedFile(const std::string &filename, bool writable);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return opened; }
+  char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  char *data_;
+  std::size_t size_;
+  bool opened;
+#ifdef _WIN32
+  std::vector<char> buffer;
+#endif
+};
+
+#ifndef _WIN32
+MappedFile::MappedFile(const std::string &filename, bool writable)
+    : data_(nullptr), size_(0), opened(false) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat info;
+  if (fstat(fd, &info) == 0) {
+    size_ = info.st_size;
+    if (size_ == 0) {
+      opened = true; // mmap refuses empty files
+    } else {
+      void *mapped =
+          mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+               MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        data_ = static_cast<char *>(mapped);
+        opened = true;
+        // Read-only mappings are only ever read front to back
+        if (!writable)
+          madvise(mapped, size_, MADV_SEQUENTIAL);
+      }
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr)
+    munmap(data_, size_);
+}
+#else
+MappedFile::MappedFile(const std::string &filename, bool)
+    : data_(nullptr), size_(0), opened(false) {
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+    return;
+  buffer.resize(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(buffer.data(), buffer.size());
+  if (!file)
+    return;
+  data_ = buffer.data();
+  size_ = buffer.size();
+  opened = true;
+}
+
+MappedFile::~MappedFile() {}
+#endif
+
+// Layout of a text maze: height rows of width chars, each followed by the
+// line end of the first line (the last one possibly without)
+struct TextLayout {
+  int width, height;
+  std::size_t lineLength; // width plus line end
+};
+
+// Function to report the first line of a text maze whose width differs from
+// the first line's
+static void reportRaggedLine(const MappedFile &file,
+                             const std::string &filename, int width) {
+  const char *data = file.data();
+  const char *end = data + file.size();
+  for (long line = 1; data < end; ++line) {
+    const char *next =
+        static_cast<const char *>(std::memchr(data, '\n', end - data));
+    const char *lineEnd = next != nullptr ? next : end;
+    if (lineEnd > data && lineEnd[-1] == '\r')
+      --lineEnd;
+    if (std::memchr(data, '\r', lineEnd - data) != nullptr) {
+      std::cerr << filename << ": line " << line << " contains a '\\r'"
+                << std::endl;
+      return;
+    }
+    if (lineEnd - data != width) {
+      std::cerr << filename << ": line " << line << " has "
+                << (lineEnd - data) << " cells, expected " << width
+                << std::endl;
+      return;
+    }
+    data = next != nullptr ? next + 1 : end;
+  }
+  std::cerr << filename << ": mixed line ends" << std::endl;
+}
+
+// Function to find the layout of a mapped text maze from its first line and
+// its size; rows are checked one by one as they are used (see isWholeRow)
+static bool findTextLayout(const MappedFile &file, const std::string &filename,
+                           TextLayout &layout) {
+  const char *data = file.data();
+  std::size_t size = file.size();
+  const char *newline = size == 0 ? nullptr
+                                  : static_cast<const char *>(
+                                        std::memchr(data, '\n', size));
+  std::size_t width = newline != nullptr ? newline - data : size;
+  if (width > 0 && data[width - 1] == '\r')
+    --width;
+  if (width == 0) {
+    std::cerr << filename << ": no maze in file" << std::endl;
+    return false;
+  }
+  if (width > static_cast<std::size_t>(std::numeric_limits<int>::max() - 66)) {
+    std::cerr << filename << ": rows too wide" << std::endl;
+    return false;
+  }
+
+  // Without a line end after the last row the file is one line end short
+  // of whole lines. Only a file that does not end in '\n' may be; a file of
+  // one line without '\n' is that line.
+  std::size_t lineLength = newline != nullptr ? newline - data + 1 : size;
+  std::size_t lineEnd = lineLength - width;
+  std::size_t lines =
+      newline == nullptr || data[size - 1] == '\n' ? size : size + lineEnd;
+  if (lines % lineLength != 0) {
+    reportRaggedLine(file, filename, width);
+    return false;
+  }
+  std::size_t height = lines / lineLength;
+  // Grid and BitMaze index their cells with int
+  if (height > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+      !BitMaze::fits(width, height)) {
+    std::cerr << filename << ": maze too large" << std::endl;
+    return false;
+  }
+
+  layout.width = width;
+  layout.height = height;
+  layout.lineLength = lineLength;
+  return true;
+}
+
+// Function to check that row y of a text maze is width cells with no line
+// end among them, followed by the same line end as the first row (or by the
+// end of the file, for the last row)
+static bool isWholeRow(const MappedFile &file, const TextLayout &layout,
+                       int y) {
+  const char *row = file.data() + y * layout.lineLength;
+  if (std::memchr(row, '\n', layout.width) != nullptr ||
+      std::memchr(row, '\r', layout.width) != nullptr)
+    return false;
+  std::size_t offset = y * layout.lineLength + layout.width;
+  std::size_t length = layout.lineLength - layout.width;
+  if (y == layout.height - 1 && offset == file.size())
+    return true;
+  return offset + length <= file.size() &&
+         std::memcmp(file.data() + offset, file.data() + layout.width,
+                     length) == 0;
+}
+
+// Function to pack one row of chars into wall words, border and padding
+// included (the words of row y of a Bitmap)
+static void packRow(const char *row, int width, int rowWords,
+                    std::uint64_t *words) {
+  for (int w = 0; w < rowWords; ++w)
+    words[w] = ~std::uint64_t(0);
+  for (int x = 0; x < width; ++x) {
+    if (row[x] != WALL)
+      words[(x + 1) >> 6] &= ~(std::uint64_t(1) << ((x + 1) & 63));
+  }
+}
+
+// Function to write the header of a binary maze
+static void writeBinaryHeader(std::ostream &out, int width, int height,
+                              int rowWords) {
+  std::int32_t header[4] = {BINARY_VERSION, width, height, rowWords};
+  std::uint64_t words = std::uint64_t(height + 2) * rowWords;
+  out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(&words), sizeof(words));
+}
+
+// Function to write a binary maze whose rows of chars come from rowAt(y),
+// packed one at a time; rowAt returns nullptr to give up
+template <class RowAt>
+static bool writeBinaryRows(const std::string &filename, int width,
+                            int height, RowAt rowAt) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open file: " << filename << std::endl;
+    return false;
+  }
+  int rowWords = (width + 2 + 63) / 64;
+  std::vector<std::uint64_t> border(rowWords, ~std::uint64_t(0));
+  std::vector<std::uint64_t> words(rowWords);
+  writeBinaryHeader(file, width, height, rowWords);
+  file.write(reinterpret_cast<const char *>(border.data()),
+             rowWords * sizeof(std::uint64_t));
+  for (int y = 0; y < height && file; ++y) {
+    const char *row = rowAt(y);
+    if (row == nullptr)
+      return false;
+    packRow(row, width, rowWords, words.data());
+    file.write(reinterpret_cast<const char *>(words.data()),
+               rowWords * sizeof(std::uint64_t));
+  }
+  file.write(reinterpret_cast<const char *>(border.data()),
+             rowWords * sizeof(std::uint64_t));
+  if (!file) {
+    std::cerr << "Failed to write " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+Grid loadTextMaze(const std::string &filename) {
+  MappedFile file(filename, false);
+  if (!file.isOpen()) {
+    std::cerr << "Failed to open file: " << filename << std::endl;
+    return Grid();
+  }
+  TextLayout layout;
+  if (!findTextLayout(file, filename, layout))
+    return Grid();
+
+  Grid maze(layout.width, layout.height);
+  for (int y = 0; y < layout.height; ++y) {
+    if (!isWholeRow(file, layout, y)) {
+      reportRaggedLine(file, filename, layout.width);
+      return Grid();
+    }
+    std::memcpy(maze.row(y), file.data() + y * layout.lineLength,
+                layout.width);
+  }
+  return maze;
+}
+
+template <class Maze>
+static bool writeText(const std::string &filename, const Maze &maze) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open file: " << filename << std::endl;
+    return false;
+  }
+  std::string block;
+  block.reserve(TEXT_BLOCK + maze.width() + 1);
+  for (int y = 0; y < maze.height() && file; ++y) {
+    for (int x = 0; x < maze.width(); ++x)
+      block.push_back(maze(x, y));
+    block.push_back('\n');
+    if (block.size() >= TEXT_BLOCK) {
+      file.write(block.data(), block.size());
+      block.clear();
+    }
+  }
+  file.write(block.data(), block.size());
+  if (!file) {
+    std::cerr << "Failed to write " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool saveTextMaze(const std::string &filename, const Grid &maze) {
+  return writeText(filename, maze);
+}
+
+bool saveTextMaze(const std::string &filename, const BitMaze &maze) {
+  return writeText(filename, maze);
+}
+
+BitMaze loadBinaryMaze(const std::string &filename) {
+  std::shared_ptr<MappedFile> file(new MappedFile(filename, true));
+  if (!file->isOpen()) {
+    std::cerr << "Failed to open file: " << filename << std::endl;
+    return BitMaze();
+  }
+
+  std::int32_t header[4];
+  std::uint64_t words;
+  if (file->size() < BINARY_HEADER ||
+      std::memcmp(file->data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+    std::cerr << filename << ": not a binary maze" << std::endl;
+    return BitMaze();
+  }
+  std::memcpy(header, file->data() + 8, sizeof(header));
+  std::memcpy(&words, file->data() + 24, sizeof(words));
+  int width = header[1];
+  int height = header[2];
+  long long rowWords = (width + 65LL) / 64;
+  if (header[0] == 0x01000000) {
+    std::cerr << filename << ": binary maze from a machine with the other "
+              << "byte order" << std::endl;
+    return BitMaze();
+  }
+  if (header[0] != BINARY_VERSION || width <= 0 || height <= 0 ||
+      header[3] != rowWords ||
+      !BitMaze::fits(width, height) ||
+      words != std::uint64_t(height + 2) * rowWords ||
+      file->size() != BINARY_HEADER + words * sizeof(std::uint64_t)) {
+    std::cerr << filename << ": unsupported or damaged binary maze"
+              << std::endl;
+    return BitMaze();
+  }
+
+  // Solvers rely on the border to stop them, so check that every bit
+  // outside the maze is set; this touches two words per row at most
+  std::uint64_t *bits =
+      reinterpret_cast<std::uint64_t *>(file->data() + BINARY_HEADER);
+  const std::uint64_t ALL = ~std::uint64_t(0);
+  std::uint64_t padding = ALL << ((width + 1) & 63);
+  bool bordered = true;
+  for (int w = 0; w < rowWords; ++w)
+    bordered = bordered && bits[w] == ALL &&
+               bits[std::size_t(height + 1) * rowWords + w] == ALL;
+  for (int y = 1; y <= height && bordered; ++y) {
+    const std::uint64_t *row = bits + std::size_t(y) * rowWords;
+    bordered = (row[0] & 1) && (row[rowWords - 1] & padding) == padding;
+  }
+  if (!bordered) {
+    std::cerr << filename << ": binary maze without a border" << std::endl;
+    return BitMaze();
+  }
+  return BitMaze(Bitmap(width, height, bits, file));
+}
+
+bool saveBinaryMaze(const std::string &filename, const BitMaze &maze) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open file: " << filename << std::endl;
+    return false;
+  }
+  const Bitmap &bits = maze.wallBits();
+  writeBinaryHeader(file, maze.width(), maze.height(), bits.rowWords());
+  file.write(reinterpret_cast<const char *>(bits.words()), bits.bytes());
+  if (!file) {
+    std::cerr << "Failed to write " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool saveBinaryMaze(const std::string &filename, const Grid &maze) {
+  return writeBinaryRows(filename, maze.width(), maze.height(),
+                         [&](int y) { return maze.row(y); });
+}
+
+bool isBinaryMaze(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  char magic[sizeof(BINARY_MAGIC)];
+  file.read(magic, sizeof(magic));
+  return file && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+bool convertMaze(const std::string &input, const std::string &output) {
+  if (isBinaryMaze(input)) {
+    BitMaze maze = loadBinaryMaze(input);
+    return !maze.empty() && saveTextMaze(output, maze);
+  }
+
+  MappedFile text(input, false);
+  if (!text.isOpen()) {
+    std::cerr << "Failed to open file: " << input << std::endl;
+    return false;
+  }
+  TextLayout layout;
+  if (!findTextLayout(text, input, layout))
+    return false;
+  return writeBinaryRows(output, layout.width, layout.height,
+                         [&](int y) -> const char * {
+                           if (!isWholeRow(text, layout, y)) {
+                             reportRaggedLine(text, input, layout.width);
+                             return nullptr;
+                           }
+                           return text.data() + y * layout.lineLength;
+                         });
+}
@@ -0,0 +1,53 @@
+#ifndef MAZE_MAZEFILE_H
+#define MAZE_MAZEFILE_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include <string>
+
+// Fast loading and saving of large mazes, in two formats:
+//
+// Text: one line per row, one char per cell, as loadMaze reads and
+// streamMaze writes. Lines end in "\n" or "\r\n" (the first line decides),
+// and the last one may lack its line end. Every row must have the same
+// width; the loader reports the first line that does not.
+//
+// Binary: a 32-byte header followed by the wall bits of a BitMaze, word for
+// word in its padded layout (border and padding bits set):
+//   char     magic[8]  "MAZEBITS"
+//   int32    version   1 (a byte-swapped value means the wrong byte order)
+//   int32    width, height
+//   int32    rowWords  64-bit words per row, border and padding included
+//   uint64   words     (height + 2) * rowWords
+//   uint64   bits[words]
+// A billion-cell maze takes about 125 MB on disk, and loads without reading
+// or copying it: the BitMaze borrows the words of a private mapping of the
+// file, and the operating system pages them in as they are touched.
+//
+// All functions print what went wrong to std::cerr; loaders then return an
+// empty maze and the others return false.
+
+// Function to load a text maze by mapping the file and copying each row
+// straight into the grid, checking row widths on the way
+Grid loadTextMaze(const std::string &filename);
+// Function to write a maze as text
+bool saveTextMaze(const std::string &filename, const Grid &maze);
+bool saveTextMaze(const std::string &filename, const BitMaze &maze);
+
+// Function to map a binary maze; writes to the result stay in memory and
+// never reach the file
+BitMaze loadBinaryMaze(const std::string &filename);
+// Function to write a maze in the binary format (Grid cells other than WALL
+// are stored as EMPTY)
+bool saveBinaryMaze(const std::string &filename, const Grid &maze);
+bool saveBinaryMaze(const std::string &filename, const BitMaze &maze);
+
+// Function to tell whether a file starts with the binary magic
+bool isBinaryMaze(const std::string &filename);
+// Function to convert a maze file to the other format: binary input is
+// written as text, anything else is read as text and written as binary.
+// Rows are converted one at a time, so memory use does not grow with the
+// height of the maze.
+bool convertMaze(const std::string &input, const std::string &output);
+
+#endif // MAZE_MAZEFILE_H
@@ -0,0 +1,248 @@
+#ifndef MAZE_OPENLIST_H
+#define MAZE_OPENLIST_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Open lists (priority queues) for Dijkstra and A*. They all store plain
+// (key, cell index) entries and share one interface:
+//   reset(cells)      prepare for a search over a maze of `cells` indices
+//   push(key, index)  add a cell (IndexedHeap: add or decrease its key)
+//   pop()             remove and return an entry with the smallest key
+//   minKey()          smallest key queued, without removing it
+//   empty()
+// pop() and minKey() must not be called on an empty list (asserted).
+// Keys are integer path costs (Dijkstra) or cost + heuristic (A*).
+
+// Selects the open list used by findPathDijkstra and findPathAStar
+enum OpenListType {
+  OPEN_BINARY_HEAP = 1, // 2-ary heap, duplicates for re-pushed cells
+  OPEN_QUAD_HEAP,       // 4-ary heap: shallower, better cache use on pop
+  OPEN_BUCKET_QUEUE,    // Dial's buckets, O(1) amortized for small keys
+  OPEN_INDEXED_HEAP     // binary heap with decrease-key, no duplicates
+};
+
+struct OpenEntry {
+  int key;
+  int index;
+};
+
+// d-ary min-heap of OpenEntry values
+template <int D> class DaryHeap {
+public:
+  void reset(int) { heap.clear(); }
+  bool empty() const { return heap.empty(); }
+  std::size_t size() const { return heap.size(); }
+  int minKey() const {
+    assert(!heap.empty());
+    return heap[0].key;
+  }
+
+  void push(int key, int index) {
+    std::size_t hole = heap.size();
+    heap.push_back(OpenEntry());
+    while (hole > 0) {
+      std::size_t parent = (hole - 1) / D;
+      if (heap[parent].key <= key)
+        break;
+      heap[hole] = heap[parent];
+      hole = parent;
+    }
+    OpenEntry entry = {key, index};
+    heap[hole] = entry;
+  }
+
+  OpenEntry pop() {
+    assert(!heap.empty());
+    OpenEntry top = heap[0];
+    OpenEntry last = heap.back();
+    heap.pop_back();
+    std::size_t count = heap.size();
+    if (count == 0)
+      return top;
+    // Move the hole down along the smallest children, then drop last in
+    std::size_t hole = 0;
+    for (;;) {
+      std::size_t first = hole * D + 1;
+      if (first >= count)
+        break;
+      std::size_t end = first + D < count ? first + D : count;
+      std::size_t best = first;
+      for (std::size_t child = first + 1; child < end; ++child) {
+        if (heap[child].key < heap[best].key)
+          best = child;
+      }
+      if (heap[best].key >= last.key)
+        break;
+      heap[hole] = heap[best];
+      hole = best;
+    }
+    heap[hole] = last;
+    return top;
+  }
+
+private:
+  std::vector<OpenEntry> heap;
+};
+
+typedef DaryHeap<2> BinaryHeap;
+typedef DaryHeap<4> QuadHeap;
+
+// Dial's bucket queue for monotone integer keys: a ring of buckets covering
+// the keys [current, current + ring size), one key per bucket, where current
+// is the last key popped. Pushing a key further ahead grows the ring. Keys
+// must not drop below current (asserted; keys of Dijkstra and of A* with a
+// consistent heuristic never do): the ring has no bucket for them, and
+// release builds file them under current. Within a bucket entries pop LIFO, which makes A*
+// favour the most recently reached cell on ties.
+class BucketQueue {
+public:
+  BucketQueue() : buckets(4), mask(3), current(0), count(0), anchored(false) {}
+
+  void reset(int) {
+    for (std::vector<int> &bucket : buckets)
+      bucket.clear();
+    current = 0;
+    count = 0;
+    anchored = false;
+  }
+  bool empty() const { return count == 0; }
+  std::size_t size() const { return count; }
+  int minKey() {
+    // On an empty queue no bucket would ever stop the scan
+    assert(count > 0);
+    while (buckets[current & mask].empty())
+      ++current;
+    return current;
+  }
+
+  void push(int key, int index) {
+    // The first key anchors the ring; later keys are measured from the last
+    // key popped, even when the queue ran empty in between
+    if (!anchored) {
+      current = key;
+      anchored = true;
+    }
+    assert(key >= current);
+    if (key < current)
+      key = current;
+    if (key - current > mask)
+      grow(key - current + 1);
+    buckets[key & mask].push_back(index);
+    ++count;
+  }
+
+  OpenEntry pop() {
+    minKey(); // advance current to the first non-empty bucket
+    std::vector<int> &bucket = buckets[current & mask];
+    OpenEntry entry = {current, bucket.back()};
+    bucket.pop_back();
+    --count;
+    return entry;
+  }
+
+private:
+  // Function to enlarge the ring to at least span buckets; every bucket
+  // holds a single key, so buckets move as a whole
+  void grow(int span) {
+    int size = buckets.size();
+    while (size < span)
+      size *= 2;
+    std::vector<std::vector<int> > larger(size);
+    for (int offset = 0; offset <= mask; ++offset) {
+      int key = current + offset;
+      larger[key & (size - 1)].swap(buckets[key & mask]);
+    }
+    buckets.swap(larger);
+    mask = size - 1;
+  }
+
+  std::vector<std::vector<int> > buckets;
+  int mask;
+  int current;       // smallest key that may still be in the queue
+  std::size_t count; // entries over all buckets
+  bool anchored;     // whether current is set since the last reset
+};
+
+// Binary min-heap holding each cell at most once. Pushing a cell that is
+// already queued lowers its key when the new key is smaller (decrease-key)
+// and is ignored otherwise, so the heap never grows past the frontier size.
+class IndexedHeap {
+public:
+  void reset(int cells) {
+    for (const OpenEntry &entry : heap)
+      position[entry.index] = -1;
+    heap.clear();
+    if (static_cast<int>(position.size()) < cells)
+      position.resize(cells, -1);
+  }
+  bool empty() const { return heap.empty(); }
+  std::size_t size() const { return heap.size(); }
+  int minKey() const {
+    assert(!heap.empty());
+    return heap[0].key;
+  }
+
+  void push(int key, int index) {
+    int hole = position[index];
+    if (hole >= 0) {
+      if (heap[hole].key <= key)
+        return;
+    } else {
+      hole = heap.size();
+      heap.push_back(OpenEntry());
+    }
+    OpenEntry entry = {key, index};
+    siftUp(hole, entry);
+  }
+
+  OpenEntry pop() {
+    assert(!heap.empty());
+    OpenEntry top = heap[0];
+    position[top.index] = -1;
+    OpenEntry last = heap.back();
+    heap.pop_back();
+    if (!heap.empty())
+      siftDown(0, last);
+    return top;
+  }
+
+private:
+  void place(int hole, const OpenEntry &entry) {
+    heap[hole] = entry;
+    position[entry.index] = hole;
+  }
+
+  void siftUp(int hole, const OpenEntry &entry) {
+    while (hole > 0) {
+      int parent = (hole - 1) / 2;
+      if (heap[parent].key <= entry.key)
+        break;
+      place(hole, heap[parent]);
+      hole = parent;
+    }
+    place(hole, entry);
+  }
+
+  void siftDown(int hole, const OpenEntry &entry) {
+    int count = heap.size();
+    for (;;) {
+      int child = hole * 2 + 1;
+      if (child >= count)
+        break;
+      if (child + 1 < count && heap[child + 1].key < heap[child].key)
+        ++child;
+      if (heap[child].key >= entry.key)
+        break;
+      place(hole, heap[child]);
+      hole = child;
+    }
+    place(hole, entry);
+  }
+
+  std::vector<OpenEntry> heap;
+  std::vector<int> position; // heap slot of each cell index, -1 if absent
+};
+
+#endif // MAZE_OPENLIST_H
@@ -0,0 +1,185 @@
+#include "parallelbfs.h"
+#include "definitions.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Frontier cells per parallelFor index in a top-down layer, and the smallest
+// frontier worth handing to the pool
+static const int FRONTIER_CHUNK = 2048;
+static const int PARALLEL_FRONTIER = 4 * FRONTIER_CHUNK;
+// Rows per parallelFor index in a bottom-up layer or a full pass
+static const int ROW_CHUNK = 16;
+// Direction switching as in Beamer's direction-optimizing BFS: go bottom-up
+// once the frontier exceeds 1/ALPHA of the unreached cells, and back
+// top-down once it drops below 1/BETA of all open cells
+static const long ALPHA = 14;
+static const long BETA = 24;
+
+// Distances are read and written by several workers within a layer; these
+// keep every access atomic (relaxed: the pool's own locking orders layers)
+static inline int loadDistance(const int *distance, int index) {
+  return __atomic_load_n(distance + index, __ATOMIC_RELAXED);
+}
+static inline void storeDistance(int *distance, int index, int value) {
+  __atomic_store_n(distance + index, value, __ATOMIC_RELAXED);
+}
+// Function to set an unreached cell's distance; false if it was reached
+static inline bool claim(int *distance, int index, int value) {
+  int expected = -1;
+  return __atomic_compare_exchange_n(distance + index, &expected, value, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+// Function to run the layers from startIndex until every reachable cell has
+// a distance, or until the layer that reaches goalIndex (-1 for none)
+template <class Maze>
+static long searchLayers(const Maze &maze, int startIndex, int goalIndex,
+                         ThreadPool &pool, std::vector<int> &distance) {
+  distance.assign(maze.size(), -1);
+  // A wall reaches nothing, as in findDistancesBFS
+  if (maze[startIndex] == WALL)
+    return 0;
+  int *dist = distance.data();
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+  int rowBlocks = (maze.height() + ROW_CHUNK - 1) / ROW_CHUNK;
+
+  // Open cells, for the switching rule
+  std::vector<long> counts(pool.size(), 0);
+  pool.parallelFor(rowBlocks, [&](int worker, int block) {
+    int last = std::min(maze.height(), (block + 1) * ROW_CHUNK);
+    for (int y = block * ROW_CHUNK; y < last; ++y) {
+      for (int x = 0; x < maze.width(); ++x)
+        counts[worker] += maze(x, y) != WALL;
+    }
+  });
+  long open = 0;
+  for (long count : counts)
+    open += count;
+
+  std::vector<int> frontier(1, startIndex);
+  std::vector<std::vector<int> > next(pool.size());
+  dist[startIndex] = 0;
+  long reached = 1;
+  bool bottomUp = false;
+  for (int d = 1; !frontier.empty(); ++d) {
+    if (goalIndex >= 0 && dist[goalIndex] >= 0)
+      break;
+    long size = frontier.size();
+    if (!bottomUp && size * ALPHA > open - reached)
+      bottomUp = true;
+    else if (bottomUp && size * BETA < open)
+      bottomUp = false;
+    for (std::vector<int> &cells : next)
+      cells.clear();
+
+    if (bottomUp) {
+      // Every cell belongs to one row block, so only its own worker writes it
+      pool.parallelFor(rowBlocks, [&](int worker, int block) {
+        int last = std::min(maze.height(), (block + 1) * ROW_CHUNK);
+        for (int y = block * ROW_CHUNK; y < last; ++y) {
+          for (int x = 0; x < maze.width(); ++x) {
+            int i = maze.index(x, y);
+            if (maze[i] == WALL || loadDistance(dist, i) != -1)
+              continue;
+            for (int k = 0; k < 4; ++k) {
+              if (loadDistance(dist, i + offsets[k]) == d - 1) {
+                storeDistance(dist, i, d);
+                next[worker].push_back(i);
+                break;
+              }
+            }
+          }
+        }
+      });
+    } else if (size < PARALLEL_FRONTIER) {
+      for (int i : frontier) {
+        for (int k = 0; k < 4; ++k) {
+          int n = i + offsets[k];
+          if (maze[n] != WALL && dist[n] == -1) {
+            dist[n] = d;
+            next[0].push_back(n);
+          }
+        }
+      }
+    } else {
+      int chunks = (size + FRONTIER_CHUNK - 1) / FRONTIER_CHUNK;
+      pool.parallelFor(chunks, [&](int worker, int chunk) {
+        int last = std::min<long>(size, (chunk + 1) * FRONTIER_CHUNK);
+        for (int j = chunk * FRONTIER_CHUNK; j < last; ++j) {
+          int i = frontier[j];
+          for (int k = 0; k < 4; ++k) {
+            int n = i + offsets[k];
+            if (maze[n] != WALL && claim(dist, n, d))
+              next[worker].push_back(n);
+          }
+        }
+      });
+    }
+
+    frontier.clear();
+    for (const std::vector<int> &cells : next)
+      frontier.insert(frontier.end(), cells.begin(), cells.end());
+    reached += frontier.size();
+  }
+  return reached;
+}
+
+long parallelDistances(const Grid &maze, int startX, int startY,
+                       ThreadPool &pool, std::vector<int> &distance) {
+  return searchLayers(maze, maze.index(startX, startY), -1, pool, distance);
+}
+long parallelDistances(const BitMaze &maze, int startX, int startY,
+                       ThreadPool &pool, std::vector<int> &distance) {
+  return searchLayers(maze, maze.index(startX, startY), -1, pool, distance);
+}
+
+template <class Maze>
+static SearchResult searchParallel(const Maze &maze, int startX, int startY,
+                                   int goalX, int goalY, ThreadPool &pool,
+                                   MazeSink &sink) {
+  SearchResult result;
+  sink.reset(maze);
+  if (maze(startX, startY) == WALL || maze(goalX, goalY) == WALL)
+    return result;
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
+
+  std::vector<int> distance;
+  result.expanded = searchLayers(maze, startIndex, goalIndex, pool, distance);
+  if (distance[goalIndex] < 0)
+    return result;
+
+  // Every cell at distance d > 0 has a neighbour at d - 1
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+  int cell = goalIndex;
+  result.path.push_back(std::make_pair(goalX, goalY));
+  while (cell != startIndex) {
+    int d = distance[cell];
+    for (int k = 0; k < 4; ++k) {
+      if (distance[cell + offsets[k]] == d - 1) {
+        cell += offsets[k];
+        break;
+      }
+    }
+    result.path.push_back(std::make_pair(maze.xOf(cell), maze.yOf(cell)));
+    if (cell != startIndex) {
+      sink.cell(maze.xOf(cell), maze.yOf(cell), PATH);
+      sink.step();
+    }
+  }
+  std::reverse(result.path.begin(), result.path.end());
+  result.found = true;
+  return result;
+}
+
+SearchResult findPathParallelBFS(const Grid &maze, int startX, int startY,
+                                 int goalX, int goalY, ThreadPool &pool,
+                                 MazeSink &sink) {
+  return searchParallel(maze, startX, startY, goalX, goalY, pool, sink);
+}
+SearchResult findPathParallelBFS(const BitMaze &maze, int startX, int startY,
+                                 int goalX, int goalY, ThreadPool &pool,
+                                 MazeSink &sink) {
+  return searchParallel(maze, startX, startY, goalX, goalY, pool, sink);
+}
@@ -0,0 +1,43 @@
+#ifndef MAZE_PARALLELBFS_H
+#define MAZE_PARALLELBFS_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "sink.h"
+#include "solver.h"
+#include "threadpool.h"
+#include <vector>
+
+// Level-synchronous breadth-first search on the threads of a pool, for mazes
+// too large for one core. Every layer is expanded in parallel: workers take
+// chunks of the frontier, claim unreached neighbours with an atomic
+// compare-and-swap on their distance and collect them in per-worker lists.
+// When the frontier grows past a fraction of the cells still unreached, a
+// layer is computed bottom-up instead: every unreached cell looks for a
+// neighbour in the frontier, which needs no atomics and touches each cell
+// once. Small frontiers (the thin layers of corridor mazes) run on the
+// calling thread, since waking the pool would cost more than the layer.
+//
+// The pool must not be running another loop, so these cannot be called from
+// inside ThreadPool::parallelFor on the same pool.
+
+// Function to compute the distance of every cell from (startX, startY):
+// distance[maze.index(x, y)] is the number of steps, or -1 for walls and
+// cells that cannot be reached. The distances equal those of findDistancesBFS
+// (all -1 for a wall as the start). Returns the number of cells reached.
+long parallelDistances(const Grid &maze, int startX, int startY,
+                       ThreadPool &pool, std::vector<int> &distance);
+long parallelDistances(const BitMaze &maze, int startX, int startY,
+                       ThreadPool &pool, std::vector<int> &distance);
+
+// Function to find a shortest path with the parallel search; it stops after
+// the layer that reaches the goal and walks back along decreasing distances.
+// expanded counts reached cells and the sink sees the final path only.
+SearchResult findPathParallelBFS(const Grid &maze, int startX, int startY,
+                                 int goalX, int goalY, ThreadPool &pool,
+                                 MazeSink &sink = nullSink());
+SearchResult findPathParallelBFS(const BitMaze &maze, int startX, int startY,
+                                 int goalX, int goalY, ThreadPool &pool,
+                                 MazeSink &sink = nullSink());
+
+#endif // MAZE_PARALLELBFS_H
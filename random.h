@@ -0,0 +1,67 @@
+#ifndef MAZE_RANDOM_H
+#define MAZE_RANDOM_H
+
+#include <cstdint>
+#include <random>
+
+// Small, fast random number generator (xoshiro256**) owned by one generator
+// call at a time. Unlike rand() it keeps no global state, so mazes can be
+// generated on several threads at once, and the same seed always carves the
+// same maze on every platform. It also meets the requirements of a standard
+// random bit generator, but the std distributions and std::shuffle are not
+// portable between standard libraries, so the generators use below().
+class MazeRandom {
+public:
+  typedef std::uint64_t result_type;
+
+  explicit MazeRandom(std::uint64_t seed) {
+    // Spread the seed over the whole state with splitmix64, as recommended
+    // for xoshiro; a state of all zeros is never produced
+    for (std::uint64_t &word : state) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~result_type(0); }
+
+  result_type operator()() {
+    std::uint64_t result = rotate(state[1] * 5, 7) * 9;
+    std::uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotate(state[3], 45);
+    return result;
+  }
+
+  // Function to return a number in [0, bound) for bound > 0, by the
+  // multiply-shift method (no division; the bias is below 2^-32)
+  int below(int bound) {
+    return static_cast<int>(((*this)() >> 32) *
+                                static_cast<std::uint64_t>(bound) >>
+                            32);
+  }
+  bool coin() { return (*this)() >> 63; }
+
+private:
+  static std::uint64_t rotate(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  std::uint64_t state[4];
+};
+
+// Function to draw a fresh seed for runs that do not ask for one
+inline std::uint64_t randomSeed() {
+  std::random_device device;
+  return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+#endif // MAZE_RANDOM_H
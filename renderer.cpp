@@ -0,0 +1,114 @@
+#include "renderer.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+TerminalRenderer::TerminalRenderer(int fps, int stepsPerSecond, bool pad)
+    : width(0), height(0), pad(pad), fullRedraw(true),
+      frameInterval(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(fps, 1)))),
+      stepsPerSecond(stepsPerSecond), steps(0), started(Clock::now()),
+      nextFrame(Clock::duration::zero()) {}
+
+void TerminalRenderer::load(const Grid &maze) {
+  height = maze.height();
+  width = maze.width();
+  back.resize(width * height);
+  for (int y = 0; y < height; ++y)
+    std::copy(maze.row(y), maze.row(y) + width, back.begin() + y * width);
+  front = back;
+  dirty.clear();
+  queued.assign(width * height, 0);
+  fullRedraw = true;
+
+  // Worst case is a full frame, or a cursor move before every cell
+  int cellWidth = pad ? 2 : 1;
+  out.reserve(std::max(height * (width * cellWidth + 1),
+                       width * height * (cellWidth + 12)) +
+              64);
+
+  steps = 0;
+  started = Clock::now();
+  nextFrame = Clock::duration::zero();
+}
+
+void TerminalRenderer::set(int x, int y, char value) {
+  int index = y * width + x;
+  back[index] = value;
+  if (!queued[index]) {
+    queued[index] = 1;
+    dirty.push_back(index);
+  }
+}
+
+void TerminalRenderer::step() {
+  ++steps;
+  Clock::duration now = Clock::now() - started;
+  // With pacing, a step "happens" at its scheduled time, not when computed
+  Clock::duration scheduled =
+      stepsPerSecond > 0
+          ? std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(double(steps) / stepsPerSecond))
+          : now;
+  if (scheduled < nextFrame)
+    return; // coalesce into the current frame
+
+  if (now < nextFrame)
+    std::this_thread::sleep_for(nextFrame - now);
+  present();
+  nextFrame = std::max(nextFrame, std::max(now, scheduled)) + frameInterval;
+}
+
+void TerminalRenderer::flush() { present(); }
+
+void TerminalRenderer::appendMove(int row, int col) {
+  char buffer[32];
+  int length = snprintf(buffer, sizeof(buffer), "\x1b[%d;%dH", row, col);
+  out.append(buffer, length);
+}
+
+void TerminalRenderer::present() {
+  out.clear();
+  if (fullRedraw) {
+    out.append("\x1b[H\x1b[2J");
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        out.push_back(back[y * width + x]);
+        if (pad)
+          out.push_back(' ');
+      }
+      out.push_back('\n');
+    }
+    front = back;
+    fullRedraw = false;
+  } else {
+    // Cells are written in dirty order; the cursor move is skipped when the
+    // previous write already left the cursor on the right column
+    int cellWidth = pad ? 2 : 1;
+    int cursor = -1;
+    for (int index : dirty) {
+      if (front[index] == back[index])
+        continue;
+      if (index != cursor)
+        appendMove(index / width + 1, (index % width) * cellWidth + 1);
+      out.push_back(back[index]);
+      if (pad)
+        out.push_back(' ');
+      front[index] = back[index];
+      cursor = (index + 1) % width == 0 ? -1 : index + 1;
+    }
+    if (!out.empty())
+      appendMove(height + 1, 1); // park the cursor below the maze
+  }
+  for (int index : dirty)
+    queued[index] = 0;
+  dirty.clear();
+  // After a failed write the screen no longer matches front, so the next
+  // frame starts over from a cleared screen
+  if (!writeOutput(out.data(), out.size()))
+    fullRedraw = true;
+}
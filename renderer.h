@@ -0,0 +1,50 @@
+#ifndef MAZE_RENDERER_H
+#define MAZE_RENDERER_H
+
+#include "grid.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Incremental terminal renderer. It keeps a front buffer (what is on screen)
+// and a back buffer (what should be), and each frame writes only the cells
+// that differ, positioned with ANSI escape sequences, from one preallocated
+// buffer with a single write. Steps are coalesced into frames: at most fps
+// frames per second are drawn, and when stepsPerSecond > 0 the steps are
+// paced to that rate by sleeping once per frame instead of once per step.
+class TerminalRenderer {
+public:
+  explicit TerminalRenderer(int fps = 60, int stepsPerSecond = 200,
+                            bool pad = true);
+
+  // Replace the whole picture; the next frame clears the screen
+  void load(const Grid &maze);
+  // Change a single cell of the back buffer
+  void set(int x, int y, char value);
+  // Count one step and draw a frame when one is due
+  void step();
+  // Draw all pending changes now
+  void flush();
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  void present();
+  void appendMove(int row, int col);
+
+  int width, height;
+  bool pad;
+  bool fullRedraw;
+  std::vector<char> back, front;
+  std::vector<int> dirty;          // indices changed since the last frame
+  std::vector<unsigned char> queued; // whether an index is in dirty
+  std::string out;                 // output buffer, reused between frames
+
+  Clock::duration frameInterval;
+  int stepsPerSecond;
+  long steps;
+  Clock::time_point started;
+  Clock::duration nextFrame; // frame time relative to started
+};
+
+#endif // MAZE_RENDERER_H
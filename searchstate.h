@@ -0,0 +1,150 @@
+#ifndef MAZE_SEARCHSTATE_H
+#define MAZE_SEARCHSTATE_H
+
+#include "openlist.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Scratch shared by the search implementations (solver.cpp, graph.cpp); not
+// part of the public interface. Indices are maze cells for the grid searches
+// and node numbers for searches on a JunctionGraph.
+
+// Per-cell search state. stamp tells whether cost and parent belong to the
+// current query (see SearchState::reached and closed); anything else is left
+// over from an earlier query and ignored, so nothing is cleared between them.
+struct CellState {
+  unsigned stamp;
+  int cost;
+  int parent; // predecessor index, -1 for none
+};
+
+// Dijkstra / A* open lists, one of each kind (see openlist.h)
+struct OpenLists {
+  BinaryHeap binaryHeap;
+  QuadHeap quadHeap;
+  BucketQueue bucketQueue;
+  IndexedHeap indexedHeap;
+};
+
+// Buffers of the bit-parallel BFS (bitbfs.cpp), one word per 8x8 block of
+// cells. Bit planes cannot carry stamps, so a query clears visited and the
+// phase planes again at the blocks it listed in touched; frontier and next
+// are left all zero by every query anyway. seen and listed are stamped
+// instead: with the running layer count and query count respectively.
+struct BitSearchState {
+  std::vector<std::uint64_t> frontier, next, visited, phase0, phase1;
+  std::vector<unsigned> seen;   // layer that last expanded the block
+  std::vector<unsigned> listed; // query that last added it to touched
+  std::vector<int> active, nextActive, touched;
+  unsigned layer = 0;
+  unsigned query = 0;
+
+  // Function to start a query over count blocks
+  void begin(int count) {
+    if (static_cast<int>(visited.size()) != count) {
+      frontier.assign(count, 0);
+      next.assign(count, 0);
+      visited.assign(count, 0);
+      phase0.assign(count, 0);
+      phase1.assign(count, 0);
+      seen.assign(count, 0);
+      listed.assign(count, 0);
+      layer = query = 0;
+    } else {
+      for (int b : touched)
+        visited[b] = phase0[b] = phase1[b] = 0;
+    }
+    touched.clear();
+    if (++query == 0) {
+      // The query counter wrapped: forget every stamp once
+      std::fill(listed.begin(), listed.end(), 0);
+      query = 1;
+    }
+  }
+
+  // Function to start the next layer
+  void nextLayer() {
+    if (++layer == 0) {
+      std::fill(seen.begin(), seen.end(), 0);
+      layer = 1;
+    }
+  }
+
+  // Function to note that block b holds bits of the current query
+  void touch(int b) {
+    if (listed[b] != query) {
+      listed[b] = query;
+      touched.push_back(b);
+    }
+  }
+};
+
+// Scratch for one search at a time: per-cell state, the BFS queue, the DFS
+// stack, the open lists and the bit-parallel BFS buffers. Predecessors are
+// 32-bit cell indices in a flat array instead of heap-allocated nodes.
+// Starting a query only bumps the generation mark, so once the buffers have
+// grown to the maze size a query costs time and memory traffic in proportion
+// to the cells it touches.
+// Cell state, queue and open lists come in two sides: side 0 is the search
+// from the start, side 1 the search from the goal of a bidirectional search.
+struct SearchState {
+  std::vector<CellState> cells[2];
+  unsigned mark = 0; // even; mark is reached, mark | 1 is reached and closed
+  std::vector<int> queue[2];               // BFS queues
+  std::vector<std::pair<int, int> > stack; // DFS (cell, predecessor) pairs
+  OpenLists open[2];
+  BitSearchState bits;                     // bit-parallel BFS (bitbfs.cpp)
+
+  // Function to start a query over a maze of size cells, searched from
+  // sides directions
+  void begin(int size, int sides = 1) {
+    for (int side = 0; side < sides; ++side) {
+      if (static_cast<int>(cells[side].size()) < size) {
+        CellState fresh = {0, 0, -1};
+        cells[side].resize(size, fresh);
+      }
+    }
+    mark += 2;
+    if (mark == 0) {
+      // The generation counter wrapped: forget every stamp once
+      for (int side = 0; side < 2; ++side) {
+        for (CellState &cell : cells[side])
+          cell.stamp = 0;
+      }
+      mark = 2;
+    }
+  }
+
+  bool reached(int index, int side = 0) const {
+    return (cells[side][index].stamp | 1) == (mark | 1);
+  }
+  bool closed(int index, int side = 0) const {
+    return cells[side][index].stamp == (mark | 1);
+  }
+  int cost(int index, int side = 0) const {
+    return reached(index, side) ? cells[side][index].cost
+                                : std::numeric_limits<int>::max();
+  }
+  int parent(int index, int side = 0) const {
+    return cells[side][index].parent;
+  }
+
+  void reach(int index, int cost, int parent, int side = 0) {
+    CellState &cell = cells[side][index];
+    cell.stamp = mark;
+    cell.cost = cost;
+    cell.parent = parent;
+  }
+  void close(int index, int side = 0) { cells[side][index].stamp = mark | 1; }
+};
+
+// The free functions share one state per thread
+inline SearchState &threadSearchState() {
+  static thread_local SearchState state;
+  return state;
+}
+
+#endif // MAZE_SEARCHSTATE_H
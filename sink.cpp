@@ -0,0 +1,55 @@
+#include "sink.h"
+#include <vector>
+
+MazeSink &nullSink() {
+  static NullSink sink;
+  return sink;
+}
+
+void TerminalSink::onReset(const Grid &maze) {
+  renderer.flush();
+  renderer.load(maze);
+  renderer.flush();
+}
+
+void TerminalSink::onCell(int x, int y, char value) { renderer.set(x, y, value); }
+
+void TerminalSink::onStep() { renderer.step(); }
+
+void RecordingSink::onReset(const Grid &maze) {
+  MazeEvent event = {static_cast<int>(snapshots.size()), 0, 0,
+                     MazeEvent::RESET};
+  snapshots.push_back(maze);
+  log.push_back(event);
+}
+
+void RecordingSink::onCell(int x, int y, char value) {
+  MazeEvent event = {x, y, value, MazeEvent::CELL};
+  log.push_back(event);
+}
+
+void RecordingSink::onStep() {
+  MazeEvent event = {0, 0, 0, MazeEvent::STEP};
+  log.push_back(event);
+}
+
+void RecordingSink::replay(MazeSink &target) const {
+  for (const MazeEvent &event : log) {
+    switch (event.type) {
+    case MazeEvent::RESET:
+      target.reset(snapshots[event.x]);
+      break;
+    case MazeEvent::CELL:
+      target.cell(event.x, event.y, event.value);
+      break;
+    case MazeEvent::STEP:
+      target.step();
+      break;
+    }
+  }
+}
+
+void RecordingSink::clear() {
+  log.clear();
+  snapshots.clear();
+}
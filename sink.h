@@ -0,0 +1,104 @@
+#ifndef MAZE_SINK_H
+#define MAZE_SINK_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "renderer.h"
+#include <vector>
+
+// Observer that receives the steps of a generator or solver. Algorithms call
+// reset() once with the initial grid, cell() whenever a cell changes and
+// step() when one visual step is complete. An inactive sink (see NullSink)
+// drops every event before the virtual call, so the cost is a single branch.
+class MazeSink {
+public:
+  explicit MazeSink(bool active = true) : active_(active) {}
+  virtual ~MazeSink() {}
+
+  bool active() const { return active_; }
+
+  // The whole grid was (re)initialised
+  void reset(const Grid &maze) {
+    if (active_)
+      onReset(maze);
+  }
+  // Bit-packed mazes are expanded to a Grid only when someone listens
+  void reset(const BitMaze &maze) {
+    if (active_)
+      onReset(toGrid(maze));
+  }
+  // Cell (x, y) now holds value (EMPTY: carved, WALL: built, VISITED, PATH)
+  void cell(int x, int y, char value) {
+    if (active_)
+      onCell(x, y, value);
+  }
+  // All changes of the current step have been reported
+  void step() {
+    if (active_)
+      onStep();
+  }
+
+protected:
+  virtual void onReset(const Grid &/*maze*/) {}
+  virtual void onCell(int /*x*/, int /*y*/, char /*value*/) {}
+  virtual void onStep() {}
+
+private:
+  bool active_;
+};
+
+// Sink that ignores everything; used for headless runs
+class NullSink : public MazeSink {
+public:
+  NullSink() : MazeSink(false) {}
+};
+
+// Shared NullSink instance, the default for every algorithm
+MazeSink &nullSink();
+
+// Sink that draws the run on the terminal through a TerminalRenderer, at most
+// fps frames per second with steps paced to stepsPerSecond (0: unpaced)
+class TerminalSink : public MazeSink {
+public:
+  explicit TerminalSink(int fps = 60, int stepsPerSecond = 200)
+      : renderer(fps, stepsPerSecond) {}
+  ~TerminalSink() { flush(); }
+  // Function to draw everything still pending, e.g. before printing text
+  void flush() { renderer.flush(); }
+
+protected:
+  void onReset(const Grid &maze) override;
+  void onCell(int x, int y, char value) override;
+  void onStep() override;
+
+private:
+  TerminalRenderer renderer;
+};
+
+// One recorded event. For RESET, x indexes RecordingSink's snapshots.
+struct MazeEvent {
+  enum Type : char { RESET, CELL, STEP };
+  int x, y;
+  char value;
+  Type type;
+};
+
+// Sink that records a run so it can be replayed into another sink later
+class RecordingSink : public MazeSink {
+public:
+  const std::vector<MazeEvent> &events() const { return log; }
+  // Function to send every recorded event, in order, to target
+  void replay(MazeSink &target) const;
+  void clear();
+
+protected:
+  void onReset(const Grid &maze) override;
+  void onCell(int x, int y, char value) override;
+  void onStep() override;
+
+private:
+  std::vector<MazeEvent> log;
+  std::vector<Grid> snapshots;
+};
+
+#endif // MAZE_SINK_H
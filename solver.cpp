@@ -1,303 +1,967 @@
+#include "bitmaze.h"
 #include "definitions.h"
-#include "utils.h"
-#include <functional>
-#include <queue>
-#include <stack>
+#include "grid.h"
+#include "jumptable.h"
+#include "openlist.h"
+#include "searchstate.h"
+#include "solver.h"
+#include "sink.h"
+#include <algorithm>
+#include <cstdlib>
 #include <limits>
-
-// Helper structure to keep track of positions and their predecessors
-struct Cell {
-  int x, y;
-  Cell *prev;
-  int cost;
-  Cell(int x, int y, Cell *prev, int cost = 0)
-      : x(x), y(y), prev(prev), cost(cost) {}
-  // Overload the > operator
-  bool operator>(const Cell &other) const { return cost > other.cost; }
-};
-
-struct AStarCell {
-  int x, y;
-  AStarCell *prev;
-  int cost;
-  int f; // total cost
-  AStarCell(int x, int y, AStarCell *prev, int cost, int heuristic)
-      : x(x), y(y), prev(prev), cost(cost), f(cost + heuristic) {}
-  // Overload the > operator
-  bool operator>(const AStarCell &other) const { return f > other.f; }
-};
+#include <utility>
+#include <vector>
 
 // Choose a default heuristic for A* search
 int defaultHeuristic(int x1, int y1, int x2, int y2) {
     return abs(x1 - x2) + abs(y1 - y2);  // Example heuristic (Manhattan distance)
 }
-bool findPathAStar(std::vector<std::vector<char> > &maze, int startX, int startY, int goalX, int goalY,
-                   int (*heuristic)(int, int, int, int)) {
-  int rows = maze.size();
-  int cols = maze[0].size();
+// The searches are written once for Grid and BitMaze and instantiated by the
+// public functions at the end of this file. Search state always lives in a
+// SearchState indexed like the maze.
+
+// Directions: E, W, S, N (offsets are filled in per maze from its stride)
+static const int dx[4] = {1, -1, 0, 0};
+static const int dy[4] = {0, 0, 1, -1};
+
+// Record one expanded cell
+template <class Maze>
+static void expandCell(const Maze &maze, int index, int startIndex,
+                       SearchResult &result, MazeSink &sink) {
+  result.expanded++;
+  if (index != startIndex) {
+    sink.cell(maze.xOf(index), maze.yOf(index), VISITED);
+  }
+  sink.step(); // Visualize each step
+}
+
+// Backtrack from the goal through the parent links to report and return the
+// path
+template <class Maze>
+static void tracePath(const Maze &maze, const SearchState &state, int startIndex,
+                      int goalIndex, SearchResult &result, MazeSink &sink) {
+  for (int cell = goalIndex; cell != -1; cell = state.parent(cell)) {
+    int x = maze.xOf(cell);
+    int y = maze.yOf(cell);
+    result.path.push_back(std::make_pair(x, y));
+    if (cell != startIndex && cell != goalIndex) {
+      sink.cell(x, y, PATH);
+      sink.step();
+    }
+  }
+  std::reverse(result.path.begin(), result.path.end());
+  result.found = true;
+}
+
+template <class Maze, class OpenList>
+SearchResult searchAStar(const Maze &maze, int startX, int startY, int goalX, int goalY,
+                   int (*heuristic)(int, int, int, int), MazeSink &sink,
+                   SearchState &state, OpenList &open) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
 
-  // set up priority queue with custom comparator
-  std::priority_queue<AStarCell *, std::vector<AStarCell *>, std::greater<AStarCell *> > queue;
-  // set up costs matrix
-  std::vector<std::vector<int> > costs(
-      rows, std::vector<int>(cols, std::numeric_limits<int>::max()));
-  // set up visited matrix
-  std::vector<std::vector<bool> > visited(rows, std::vector<bool>(cols, false));
+  state.begin(maze.size());
+  // the open list is ordered on f = cost + heuristic
+  open.reset(maze.size());
 
   // Enqueue start position with cost 0
-  queue.push(new AStarCell(startX, startY, nullptr, 0, heuristic(startX, startY, goalX, goalY)));
-  costs[startY][startX] = 0;
+  open.push(heuristic(startX, startY, goalX, goalY), startIndex);
+  state.reach(startIndex, 0, -1);
 
-  int dx[4] = {1, -1, 0, 0};
-  int dy[4] = {0, 0, 1, -1};
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
 
-  while (!queue.empty()) {
-    AStarCell *current = queue.top();
-    queue.pop();
-    int x = current->x;
-    int y = current->y;
+  while (!open.empty()) {
+    int i = open.pop().index;
 
-    if (visited[y][x])
+    if (state.closed(i))
       continue;
-    visited[y][x] = true;
+    state.close(i);
 
-    if (x == goalX && y == goalY) {
-      for (AStarCell *cell = current; cell != nullptr; cell = cell->prev) {
-        if (maze[cell->y][cell->x] != GOAL && maze[cell->y][cell->x] != START)
-          maze[cell->y][cell->x] = PATH;
-        renderMaze(maze);
-      }
-      renderMaze(maze); // Final visualization
-
-      // Destruct the priority_queue
-      while (!queue.empty()) {
-        delete queue.top();
-        queue.pop();
-      }
-
-      return true;
+    if (i == goalIndex) {
+      tracePath(maze, state, startIndex, goalIndex, result, sink);
+      return result;
     }
 
-    if (maze[y][x] != START)
-      maze[y][x] = VISITED;
-    renderMaze(maze); // Visualize each step
-
-    for (int i = 0; i < 4; ++i) {
-      int nx = x + dx[i];
-      int ny = y + dy[i];
+    expandCell(maze, i, startIndex, result, sink);
 
-      int newCost = current->cost + 1;
-      int newHeuristic = heuristic(nx, ny, goalX, goalY);
-
-      if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
-          maze[ny][nx] != WALL && costs[ny][nx] > newCost) {
-        costs[ny][nx] = newCost;
-        queue.push(
-            new AStarCell(nx, ny, current, newCost, newHeuristic));
+    int x = maze.xOf(i);
+    int y = maze.yOf(i);
+    int newCost = state.cost(i) + 1;
+    for (int d = 0; d < 4; ++d) {
+      int n = i + offsets[d];
+      if (maze[n] != WALL && state.cost(n) > newCost) {
+        state.reach(n, newCost, i);
+        open.push(newCost + heuristic(x + dx[d], y + dy[d], goalX, goalY), n);
       }
     }
   }
 
-  // Destruct the priority_queue
-  while (!queue.empty()) {
-    delete queue.top();
-    queue.pop();
-  }
-  return false; // No path found
+  return result; // No path found
 }
 
-bool findPathDijkstra(std::vector<std::vector<char> > &maze, int startX, int startY, int goalX, int goalY) {
-  int rows = maze.size();
-  int cols = maze[0].size();
+template <class Maze, class OpenList>
+SearchResult searchDijkstra(const Maze &maze, int startX, int startY, int goalX, int goalY,
+                          MazeSink &sink, SearchState &state, OpenList &open) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
 
-  // Set up priority queue with custom comparator
-  std::priority_queue<Cell *, std::vector<Cell *>, std::greater<Cell *> > queue;
-  // Set up costs matrix
-  std::vector<std::vector<int> > costs(
-      rows, std::vector<int>(cols, std::numeric_limits<int>::max()));
-  // Set up visited matrix
-  std::vector<std::vector<bool> > visited(rows, std::vector<bool>(cols, false));
+  state.begin(maze.size());
+  // The open list is ordered on cost
+  open.reset(maze.size());
 
   // Enqueue start position with cost 0
-  queue.push(new Cell(startX, startY, nullptr, 0));
-  costs[startY][startX] = 0;
+  open.push(0, startIndex);
+  state.reach(startIndex, 0, -1);
 
-  int dx[4] = {1, -1, 0, 0};
-  int dy[4] = {0, 0, 1, -1};
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
 
-  while (!queue.empty()) {
-    Cell *current = queue.top();
-    queue.pop();
-    int x = current->x;
-    int y = current->y;
+  while (!open.empty()) {
+    int i = open.pop().index;
 
-    if (visited[y][x])
+    if (state.closed(i))
       continue;
-    visited[y][x] = true;
+    state.close(i);
 
-    if (x == goalX && y == goalY) {
-      for (Cell *cell = current; cell != nullptr; cell = cell->prev) {
-        if (maze[cell->y][cell->x] != GOAL && maze[cell->y][cell->x] != START)
-          maze[cell->y][cell->x] = PATH;
-        renderMaze(maze);
-      }
-      renderMaze(maze); // Final visualization
+    if (i == goalIndex) {
+      tracePath(maze, state, startIndex, goalIndex, result, sink);
+      return result;
+    }
 
-      // Destruct the priority_queue
-      while (!queue.empty()) {
-        delete queue.top();
-        queue.pop();
-      }
+    expandCell(maze, i, startIndex, result, sink);
 
-      return true;
+    int newCost = state.cost(i) + 1;
+    for (int d = 0; d < 4; ++d) {
+      int n = i + offsets[d];
+      if (maze[n] != WALL && state.cost(n) > newCost) {
+        state.reach(n, newCost, i);
+        open.push(newCost, n);
+      }
     }
+  }
 
-    if (maze[y][x] != START)
-      maze[y][x] = VISITED;
-    renderMaze(maze); // Visualize each step
+  return result; // No path found
+}
+
+template <class Maze>
+SearchResult searchBFS(const Maze &maze, int startX, int startY, int goalX, int goalY,
+                          MazeSink &sink, SearchState &state) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
 
-    for (int i = 0; i < 4; ++i) {
-      int nx = x + dx[i];
-      int ny = y + dy[i];
+  state.begin(maze.size());
 
-      int newCost = current->cost + 1;
+  // Every cell is enqueued at most once, so a flat array with a read
+  // position is enough for the queue
+  std::vector<int> &queue = state.queue[0];
+  queue.clear();
+  queue.push_back(startIndex); // Enqueue start position
+  state.reach(startIndex, 0, -1);
 
-      if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
-          maze[ny][nx] != WALL && costs[ny][nx] > newCost) {
-        costs[ny][nx] = newCost;
-        queue.push(new Cell(nx, ny, current, costs[ny][nx]));
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+
+  for (size_t head = 0; head < queue.size(); ++head) {
+    int i = queue[head];
+    // Check for goal
+    if (i == goalIndex) {
+      // Backtrack to mark the path
+      tracePath(maze, state, startIndex, goalIndex, result, sink);
+      return result;
+    }
+
+    // Mark as visited
+    expandCell(maze, i, startIndex, result, sink);
+
+    // Explore neighbors
+    for (int d = 0; d < 4; ++d) {
+      int n = i + offsets[d];
+      if (maze[n] != WALL && !state.reached(n)) {
+        state.reach(n, 0, i);
+        queue.push_back(n);
       }
     }
   }
-  
-  // Destruct the priority_queue
-  while (!queue.empty()) {
-    delete queue.top();
-    queue.pop();
+
+  return result; // No path found
+}
+
+// Breadth-first search from the start over every reachable cell, keeping the
+// number of steps to each; nothing is reported to a sink
+template <class Maze>
+long searchDistances(const Maze &maze, int startX, int startY,
+                     std::vector<int> &distance, SearchState &state) {
+  distance.assign(maze.size(), -1);
+  int startIndex = maze.index(startX, startY);
+  if (maze[startIndex] == WALL)
+    return 0;
+
+  std::vector<int> &queue = state.queue[0];
+  queue.clear();
+  queue.push_back(startIndex);
+  distance[startIndex] = 0;
+
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+  for (size_t head = 0; head < queue.size(); ++head) {
+    int i = queue[head];
+    for (int d = 0; d < 4; ++d) {
+      int n = i + offsets[d];
+      if (maze[n] != WALL && distance[n] == -1) {
+        distance[n] = distance[i] + 1;
+        queue.push_back(n);
+      }
+    }
   }
-  return false; // No path found
+  return queue.size();
 }
 
-bool findPathBFS(std::vector<std::vector<char> > &maze, int startX, int startY, int goalX, int goalY) {
-  int rows = maze.size();
-  int cols = maze[0].size();
+template <class Maze>
+SearchResult searchDFS(const Maze &maze, int startX, int startY, int goalX, int goalY,
+                          MazeSink &sink, SearchState &state) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
 
-  std::queue<Cell *> queue;
-  queue.push(new Cell(startX, startY, nullptr)); // Enqueue start position
+  state.begin(maze.size());
 
-  std::vector<std::vector<bool> > visited(rows, std::vector<bool>(cols, false));
-  visited[startY][startX] = true;
+  // Stack entries are (cell, predecessor) index pairs; a cell's parent is
+  // fixed when it is popped and expanded, as with the original node stack
+  std::vector<std::pair<int, int> > &stack = state.stack;
+  stack.clear();
+  stack.push_back(std::make_pair(startIndex, -1));
 
-  int dx[4] = {1, -1, 0, 0};
-  int dy[4] = {0, 0, 1, -1};
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+
+  while (!stack.empty()) {
+    int i = stack.back().first;
+    int from = stack.back().second;
+    stack.pop_back();
+
+    // Check walls; cells past the edge are sentinel walls
+    if (maze[i] == WALL || state.reached(i)) {
+      continue;
+    }
+    state.reach(i, 0, from);
 
-  while (!queue.empty()) {
-    Cell *current = queue.front();
-    queue.pop();
-    
-    int x = current->x;
-    int y = current->y;
     // Check for goal
-    if (x == goalX && y == goalY) {
+    if (i == goalIndex) {
       // Backtrack to mark the path
-      for (Cell *cell = current; cell != nullptr; cell = cell->prev) {
-        if (maze[cell->y][cell->x] != GOAL && maze[cell->y][cell->x] != START)
-          maze[cell->y][cell->x] = PATH;
-        renderMaze(maze);
-      }
-      renderMaze(maze); // Final visualization
- 
-      // Destruct the priority_queue
-      while (!queue.empty()) {
-        delete queue.front();
-        queue.pop();
-      }
-
-      return true;
+      tracePath(maze, state, startIndex, goalIndex, result, sink);
+      return result;
     }
 
-    // Mark as visited
-    if (maze[y][x] != START)
-      maze[y][x] = VISITED;
-    renderMaze(maze); // Visualize each step
+    // Mark the current cell as visited
+    expandCell(maze, i, startIndex, result, sink);
 
     // Explore neighbors
-    for (int i = 0; i < 4; ++i) {
-      int nx = x + dx[i];
-      int ny = y + dy[i];
-
-      if (nx >= 0 && nx < cols && ny >= 0 && ny < rows &&
-          maze[ny][nx] != WALL && !visited[ny][nx]) {
-        visited[ny][nx] = true;
-        queue.push(new Cell(nx, ny, current));
+    for (int direction = 0; direction < 4; ++direction) {
+      stack.push_back(std::make_pair(i + offsets[direction], i));
+    }
+  }
+
+  return result;
+}
+
+// Join the two halves of a bidirectional search: the path runs from the start
+// to forwardCell through the side 0 parents and then on from backwardCell to
+// the goal through the side 1 parents
+template <class Maze>
+static void traceMeeting(const Maze &maze, const SearchState &state,
+                         int startIndex, int goalIndex, int forwardCell,
+                         int backwardCell, SearchResult &result,
+                         MazeSink &sink) {
+  for (int cell = forwardCell; cell != -1; cell = state.parent(cell, 0))
+    result.path.push_back(std::make_pair(maze.xOf(cell), maze.yOf(cell)));
+  std::reverse(result.path.begin(), result.path.end());
+  for (int cell = backwardCell; cell != -1; cell = state.parent(cell, 1))
+    result.path.push_back(std::make_pair(maze.xOf(cell), maze.yOf(cell)));
+
+  for (const std::pair<int, int> &cell : result.path) {
+    int index = maze.index(cell.first, cell.second);
+    if (index != startIndex && index != goalIndex) {
+      sink.cell(cell.first, cell.second, PATH);
+      sink.step();
+    }
+  }
+  result.found = true;
+}
+
+// Breadth-first search from both ends at once. Each round expands one whole
+// layer of the smaller frontier; once a layer touches a cell reached from
+// the other end, the shortest of the connections found in that layer is the
+// shortest path.
+template <class Maze>
+SearchResult searchBidirectionalBFS(const Maze &maze, int startX, int startY,
+                                    int goalX, int goalY, MazeSink &sink,
+                                    SearchState &state) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
+  if (startIndex == goalIndex) {
+    result.path.push_back(std::make_pair(startX, startY));
+    result.found = true;
+    return result;
+  }
+
+  state.begin(maze.size(), 2);
+  size_t head[2] = {0, 0};
+  for (int side = 0; side < 2; ++side) {
+    int origin = side == 0 ? startIndex : goalIndex;
+    state.queue[side].clear();
+    state.queue[side].push_back(origin);
+    state.reach(origin, 0, -1, side);
+  }
+
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+
+  int best = std::numeric_limits<int>::max();
+  int meetForward = -1, meetBackward = -1;
+  while (head[0] < state.queue[0].size() && head[1] < state.queue[1].size()) {
+    int side = state.queue[0].size() - head[0] <=
+                       state.queue[1].size() - head[1]
+                   ? 0
+                   : 1;
+    int other = 1 - side;
+    std::vector<int> &queue = state.queue[side];
+    size_t layerEnd = queue.size();
+
+    for (; head[side] < layerEnd; ++head[side]) {
+      int i = queue[head[side]];
+      expandCell(maze, i, startIndex, result, sink);
+
+      int newCost = state.cost(i, side) + 1;
+      for (int d = 0; d < 4; ++d) {
+        int n = i + offsets[d];
+        if (maze[n] == WALL)
+          continue;
+        if (state.reached(n, other)) {
+          // The frontiers touch on the edge i-n
+          int total = newCost + state.cost(n, other);
+          if (total < best) {
+            best = total;
+            meetForward = side == 0 ? i : n;
+            meetBackward = side == 0 ? n : i;
+          }
+        } else if (!state.reached(n, side)) {
+          state.reach(n, newCost, i, side);
+          queue.push_back(n);
+        }
       }
     }
+
+    if (meetForward != -1) {
+      traceMeeting(maze, state, startIndex, goalIndex, meetForward,
+                   meetBackward, result, sink);
+      return result;
+    }
   }
-  
-  // Destruct the priority_queue
-  while (!queue.empty()) {
-    delete queue.front();
-    queue.pop();
+
+  return result; // No path found
+}
+
+// A* from both ends at once. Both sides are ordered on the average of the
+// two heuristics (Ikeda et al.): a cell v gets the potential
+// p(v) = (h(v, goal) - h(v, start)) / 2 in the start search and -p(v) in the
+// goal search, which keeps both consistent and makes the search a
+// bidirectional Dijkstra on reduced costs. Keys are doubled to stay integral.
+// Every improvement of a cell already reached from the other end is a
+// candidate path, and the search stops once the smallest keys of the two
+// open lists add up to twice the best candidate. Each step expands the side
+// with the smaller open list.
+template <class Maze, class OpenList>
+SearchResult searchBidirectionalAStar(const Maze &maze, int startX, int startY,
+                                      int goalX, int goalY,
+                                      int (*heuristic)(int, int, int, int),
+                                      MazeSink &sink, SearchState &state,
+                                      OpenList &forward, OpenList &backward) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = maze.index(startX, startY);
+  int goalIndex = maze.index(goalX, goalY);
+  if (startIndex == goalIndex) {
+    result.path.push_back(std::make_pair(startX, startY));
+    result.found = true;
+    return result;
   }
 
-  return false; // No path found
+  state.begin(maze.size(), 2);
+  OpenList *open[2] = {&forward, &backward};
+  // Twice the potential of (x, y) for the given side
+  auto potential = [&](int x, int y, int side) {
+    int p = heuristic(x, y, goalX, goalY) - heuristic(x, y, startX, startY);
+    return side == 0 ? p : -p;
+  };
+
+  forward.reset(maze.size());
+  backward.reset(maze.size());
+  forward.push(potential(startX, startY, 0), startIndex);
+  backward.push(potential(goalX, goalY, 1), goalIndex);
+  state.reach(startIndex, 0, -1, 0);
+  state.reach(goalIndex, 0, -1, 1);
+
+  // The sentinel border means no neighbour index is ever out of range
+  int offsets[4] = {1, -1, maze.stride(), -maze.stride()};
+
+  int best = std::numeric_limits<int>::max();
+  int meet = -1; // cell reached from both ends on the best path
+  while (!forward.empty() && !backward.empty()) {
+    if (meet != -1 && forward.minKey() + backward.minKey() >= 2 * best)
+      break;
+
+    int side = forward.size() <= backward.size() ? 0 : 1;
+    int other = 1 - side;
+    int i = open[side]->pop().index;
+
+    if (state.closed(i, side))
+      continue;
+    state.close(i, side);
+
+    expandCell(maze, i, startIndex, result, sink);
+
+    int x = maze.xOf(i);
+    int y = maze.yOf(i);
+    int newCost = state.cost(i, side) + 1;
+    for (int d = 0; d < 4; ++d) {
+      int n = i + offsets[d];
+      if (maze[n] != WALL && state.cost(n, side) > newCost) {
+        state.reach(n, newCost, i, side);
+        open[side]->push(2 * newCost + potential(x + dx[d], y + dy[d], side),
+                         n);
+        if (state.reached(n, other) && newCost + state.cost(n, other) < best) {
+          best = newCost + state.cost(n, other);
+          meet = n;
+        }
+      }
+    }
+  }
+
+  if (meet != -1) {
+    // The forward chain from meet leads to the start, the backward chain from
+    // its successor to the goal (empty when meet is the goal itself)
+    traceMeeting(maze, state, startIndex, goalIndex, meet,
+                 state.parent(meet, 1), result, sink);
+  }
+  return result;
 }
 
-bool findPathDFS(std::vector<std::vector<char> > &maze, int startX, int startY, int goalX, int goalY) {
-  std::stack<Cell *> stack;
-  stack.push(new Cell(startX, startY, nullptr, 0));
+// Jump Point Search for 4-connected grids. Among equally short paths it only
+// follows the canonical ones: a horizontal run turns vertical only where the
+// cell diagonally behind it is a wall (any other turn could have been taken
+// one cell earlier), while a vertical run may turn at any cell. So only cells
+// where a canonical path can change direction become search nodes, and
+// straight runs between them are skipped by a jump. A node is a cell plus the
+// axis it was entered on (side 0 horizontal, side 1 vertical), since the two
+// allow different turns; open list entries hold cell * 2 + side, and so do
+// the parent links.
+//
+// The jumps come from a jumper: ScanJumps walks the maze, TableJumps reads
+// precomputed distances (JPS+). Both work in their own index space.
+
+// Jumps found by walking the maze cell by cell
+template <class Maze> class ScanJumps {
+public:
+  ScanJumps(const Maze &maze, int goalX, int goalY)
+      : maze(maze), goal(maze.index(goalX, goalY)) {}
+
+  int size() const { return maze.size(); }
+  int stride() const { return maze.stride(); }
+  int index(int x, int y) const { return maze.index(x, y); }
+  int xOf(int index) const { return maze.xOf(index); }
+  int yOf(int index) const { return maze.yOf(index); }
+  bool open(int index) const { return maze[index] != WALL; }
+
+  // Function to find the next jump point from cell in horizontal direction
+  // step (+1 or -1), -1 if there is none
+  int jumpH(int cell, int step) const {
+    int stride = maze.stride();
+    for (;;) {
+      cell += step;
+      if (maze[cell] == WALL)
+        return -1;
+      if (cell == goal ||
+          (maze[cell + stride] != WALL && maze[cell - step + stride] == WALL) ||
+          (maze[cell - stride] != WALL && maze[cell - step - stride] == WALL))
+        return cell;
+    }
+  }
+  // Function to find the next jump point from cell in vertical direction
+  // step (+stride or -stride), -1 if there is none
+  int jumpV(int cell, int step) const {
+    for (;;) {
+      cell += step;
+      if (maze[cell] == WALL)
+        return -1;
+      if (cell == goal || jumpH(cell, 1) != -1 || jumpH(cell, -1) != -1)
+        return cell;
+    }
+  }
 
-  static const int dx[] = {1, -1, 0, 0};
-  static const int dy[] = {0, 0, 1, -1};
+private:
+  const Maze &maze;
+  int goal;
+};
 
-  while (!stack.empty()) {
-    Cell *current = stack.top();
-    stack.pop();
+// Jumps read from a JumpTable. The table knows nothing about the goal, so a
+// jump that passes the goal, or the goal's row on a vertical jump, stops
+// there instead.
+class TableJumps {
+public:
+  TableJumps(const JumpTable &table, int goalX, int goalY)
+      : table(table), goalX(goalX), goalY(goalY) {}
+
+  int size() const { return table.size(); }
+  int stride() const { return table.stride(); }
+  int index(int x, int y) const { return table.index(x, y); }
+  int xOf(int index) const { return table.xOf(index); }
+  int yOf(int index) const { return table.yOf(index); }
+  bool open(int index) const { return table.open(index); }
+
+  int jumpH(int cell, int step) const {
+    int distance = table.jump(cell, step > 0 ? 0 : 1);
+    int y = table.yOf(cell);
+    int toGoal = (goalX - table.xOf(cell)) * step;
+    if (y == goalY && toGoal > 0 && toGoal <= std::abs(distance))
+      return table.index(goalX, goalY);
+    return distance > 0 ? cell + distance * step : -1;
+  }
+  int jumpV(int cell, int step) const {
+    int direction = step > 0 ? 2 : 3;
+    int distance = table.jump(cell, direction);
+    int x = table.xOf(cell);
+    int toGoalRow = (goalY - table.yOf(cell)) * (step > 0 ? 1 : -1);
+    if (toGoalRow > 0 && toGoalRow <= std::abs(distance))
+      return table.index(x, goalY);
+    return distance > 0 ? cell + distance * step : -1;
+  }
 
-    int x = current->x;
-    int y = current->y;
+private:
+  const JumpTable &table;
+  int goalX, goalY;
+};
 
-    // Check bounds and walls
-    if (x < 0 || x >= maze[0].size() || y < 0 || y >= maze.size() ||
-        maze[y][x] == WALL || maze[y][x] == VISITED) {
+template <class Maze, class Jumper, class OpenList>
+SearchResult searchJPS(const Maze &maze, const Jumper &jumper, int startX,
+                       int startY, int goalX, int goalY,
+                       int (*heuristic)(int, int, int, int), MazeSink &sink,
+                       SearchState &state, OpenList &open) {
+  SearchResult result;
+  sink.reset(maze);
+  int startIndex = jumper.index(startX, startY);
+  int goalIndex = jumper.index(goalX, goalY);
+  int stride = jumper.stride();
+
+  state.begin(jumper.size(), 2);
+  open.reset(2 * jumper.size());
+
+  // The start may leave in all four directions, as if entered vertically
+  // with no direction to keep
+  open.push(heuristic(startX, startY, goalX, goalY), startIndex * 2 + 1);
+  state.reach(startIndex, 0, -1, 1);
+
+  int successors[4];
+  while (!open.empty()) {
+    int node = open.pop().index;
+    int i = node >> 1;
+    int side = node & 1;
+
+    if (state.closed(i, side))
       continue;
+    state.close(i, side);
+
+    if (i == goalIndex) {
+      // Unroll the parent links, filling in the cells jumped over
+      for (int at = node; at != -1; at = state.parent(at >> 1, at & 1)) {
+        int cell = at >> 1;
+        int from = state.parent(cell, at & 1);
+        if (from == -1) {
+          result.path.push_back(std::make_pair(jumper.xOf(cell), jumper.yOf(cell)));
+          break;
+        }
+        int previous = from >> 1;
+        int step = jumper.yOf(cell) == jumper.yOf(previous) ? 1 : stride;
+        if (cell < previous)
+          step = -step;
+        for (int c = cell; c != previous; c -= step)
+          result.path.push_back(std::make_pair(jumper.xOf(c), jumper.yOf(c)));
+      }
+      std::reverse(result.path.begin(), result.path.end());
+      for (const std::pair<int, int> &cell : result.path) {
+        int index = jumper.index(cell.first, cell.second);
+        if (index != startIndex && index != goalIndex) {
+          sink.cell(cell.first, cell.second, PATH);
+          sink.step();
+        }
+      }
+      result.found = true;
+      return result;
     }
 
-    // Check for goal
-    if (x == goalX && y == goalY) {
-      // Backtrack to mark the path
-      for (Cell *cell = current; cell != nullptr; cell = cell->prev) {
-        if (maze[cell->y][cell->x] != GOAL && maze[cell->y][cell->x] != START)
-          maze[cell->y][cell->x] = PATH;
-        renderMaze(maze);
+    expandCell(jumper, i, startIndex, result, sink);
+
+    // Successors depend on how i was entered
+    int count = 0;
+    int from = state.parent(i, side);
+    if (from == -1) {
+      successors[count++] = jumper.jumpH(i, 1);
+      successors[count++] = jumper.jumpH(i, -1);
+      successors[count++] = jumper.jumpV(i, stride);
+      successors[count++] = jumper.jumpV(i, -stride);
+    } else if (side == 0) {
+      // Keep going, or turn where the turn is forced
+      int step = i > (from >> 1) ? 1 : -1;
+      successors[count++] = jumper.jumpH(i, step);
+      for (int turn = -stride; turn <= stride; turn += 2 * stride) {
+        if (jumper.open(i + turn) && !jumper.open(i - step + turn))
+          successors[count++] = jumper.jumpV(i, turn);
       }
-      renderMaze(maze);
+    } else {
+      // Keep going, or turn either way
+      int step = i > (from >> 1) ? stride : -stride;
+      successors[count++] = jumper.jumpV(i, step);
+      successors[count++] = jumper.jumpH(i, 1);
+      successors[count++] = jumper.jumpH(i, -1);
+    }
 
-    // destruct the stack
-    while (!stack.empty()) {
-        delete stack.top();
-        stack.pop();
+    int x = jumper.xOf(i);
+    int y = jumper.yOf(i);
+    for (int k = 0; k < count; ++k) {
+      int n = successors[k];
+      if (n == -1)
+        continue;
+      int nx = jumper.xOf(n);
+      int ny = jumper.yOf(n);
+      int nSide = ny == y ? 0 : 1;
+      int newCost = state.cost(i, side) + std::abs(nx - x) + std::abs(ny - y);
+      if (state.cost(n, nSide) > newCost) {
+        state.reach(n, newCost, node, nSide);
+        open.push(newCost + heuristic(nx, ny, goalX, goalY), n * 2 + nSide);
       }
-
-      return true;
     }
+  }
 
-    // Mark the current cell as visited
-    if (maze[y][x] != START)
-      maze[y][x] = VISITED;
-    renderMaze(maze);
+  return result; // No path found
+}
 
-    // Explore neighbors
-    for (int direction = 0; direction < 4; ++direction) {
-      stack.push(new Cell(x + dx[direction], y + dy[direction], current));
-    }
+// Run a cost-ordered search with the selected open list
+template <class Maze>
+SearchResult searchAStarWith(OpenListType openList, const Maze &maze, int startX,
+                             int startY, int goalX, int goalY,
+                             int (*heuristic)(int, int, int, int),
+                             MazeSink &sink, SearchState &state) {
+  switch (openList) {
+  case OPEN_BINARY_HEAP:
+    return searchAStar(maze, startX, startY, goalX, goalY, heuristic, sink,
+                       state, state.open[0].binaryHeap);
+  case OPEN_QUAD_HEAP:
+    return searchAStar(maze, startX, startY, goalX, goalY, heuristic, sink,
+                       state, state.open[0].quadHeap);
+  case OPEN_INDEXED_HEAP:
+    return searchAStar(maze, startX, startY, goalX, goalY, heuristic, sink,
+                       state, state.open[0].indexedHeap);
+  case OPEN_BUCKET_QUEUE:
+  default:
+    return searchAStar(maze, startX, startY, goalX, goalY, heuristic, sink,
+                       state, state.open[0].bucketQueue);
   }
+}
 
-  // destruct the stack
-  while (!stack.empty()) {
-    delete stack.top();
-    stack.pop();
+template <class Maze>
+SearchResult searchDijkstraWith(OpenListType openList, const Maze &maze, int startX,
+                                int startY, int goalX, int goalY,
+                                MazeSink &sink, SearchState &state) {
+  switch (openList) {
+  case OPEN_BINARY_HEAP:
+    return searchDijkstra(maze, startX, startY, goalX, goalY, sink, state,
+                          state.open[0].binaryHeap);
+  case OPEN_QUAD_HEAP:
+    return searchDijkstra(maze, startX, startY, goalX, goalY, sink, state,
+                          state.open[0].quadHeap);
+  case OPEN_INDEXED_HEAP:
+    return searchDijkstra(maze, startX, startY, goalX, goalY, sink, state,
+                          state.open[0].indexedHeap);
+  case OPEN_BUCKET_QUEUE:
+  default:
+    return searchDijkstra(maze, startX, startY, goalX, goalY, sink, state,
+                          state.open[0].bucketQueue);
+  }
+}
+
+template <class Maze>
+SearchResult searchBidirectionalAStarWith(OpenListType openList,
+                                          const Maze &maze, int startX,
+                                          int startY, int goalX, int goalY,
+                                          int (*heuristic)(int, int, int, int),
+                                          MazeSink &sink, SearchState &state) {
+  OpenLists *open = state.open;
+  switch (openList) {
+  case OPEN_BINARY_HEAP:
+    return searchBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                    heuristic, sink, state,
+                                    open[0].binaryHeap, open[1].binaryHeap);
+  case OPEN_QUAD_HEAP:
+    return searchBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                    heuristic, sink, state, open[0].quadHeap,
+                                    open[1].quadHeap);
+  case OPEN_INDEXED_HEAP:
+    return searchBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                    heuristic, sink, state,
+                                    open[0].indexedHeap, open[1].indexedHeap);
+  case OPEN_BUCKET_QUEUE:
+  default:
+    return searchBidirectionalAStar(maze, startX, startY, goalX, goalY,
+                                    heuristic, sink, state,
+                                    open[0].bucketQueue, open[1].bucketQueue);
   }
+}
+
+template <class Maze, class Jumper>
+SearchResult searchJPSWith(OpenListType openList, const Maze &maze,
+                           const Jumper &jumper, int startX, int startY,
+                           int goalX, int goalY,
+                           int (*heuristic)(int, int, int, int),
+                           MazeSink &sink, SearchState &state) {
+  OpenLists &open = state.open[0];
+  switch (openList) {
+  case OPEN_BINARY_HEAP:
+    return searchJPS(maze, jumper, startX, startY, goalX, goalY, heuristic,
+                     sink, state, open.binaryHeap);
+  case OPEN_QUAD_HEAP:
+    return searchJPS(maze, jumper, startX, startY, goalX, goalY, heuristic,
+                     sink, state, open.quadHeap);
+  case OPEN_INDEXED_HEAP:
+    return searchJPS(maze, jumper, startX, startY, goalX, goalY, heuristic,
+                     sink, state, open.indexedHeap);
+  case OPEN_BUCKET_QUEUE:
+  default:
+    return searchJPS(maze, jumper, startX, startY, goalX, goalY, heuristic,
+                     sink, state, open.bucketQueue);
+  }
+}
 
-  return false;
+// Function to run JPS on maze, scanning for jumps or, given jumps, reading
+// them from the table
+template <class Maze>
+SearchResult searchJPSOn(OpenListType openList, const Maze &maze,
+                         const JumpTable *jumps, int startX, int startY,
+                         int goalX, int goalY,
+                         int (*heuristic)(int, int, int, int), MazeSink &sink,
+                         SearchState &state) {
+  if (jumps)
+    return searchJPSWith(openList, maze, TableJumps(*jumps, goalX, goalY),
+                         startX, startY, goalX, goalY, heuristic, sink, state);
+  return searchJPSWith(openList, maze, ScanJumps<Maze>(maze, goalX, goalY),
+                       startX, startY, goalX, goalY, heuristic, sink, state);
+}
+
+SearchResult findPathAStar(const Grid &maze, int startX, int startY, int goalX,
+                           int goalY, int (*heuristic)(int, int, int, int),
+                           MazeSink &sink, OpenListType openList) {
+  return searchAStarWith(openList, maze, startX, startY, goalX, goalY,
+                         heuristic, sink, threadSearchState());
+}
+SearchResult findPathAStar(const BitMaze &maze, int startX, int startY,
+                           int goalX, int goalY,
+                           int (*heuristic)(int, int, int, int),
+                           MazeSink &sink, OpenListType openList) {
+  return searchAStarWith(openList, maze, startX, startY, goalX, goalY,
+                         heuristic, sink, threadSearchState());
+}
+SearchResult findPathDijkstra(const Grid &maze, int startX, int startY, int goalX,
+                              int goalY, MazeSink &sink,
+                              OpenListType openList) {
+  return searchDijkstraWith(openList, maze, startX, startY, goalX, goalY,
+                            sink, threadSearchState());
+}
+SearchResult findPathDijkstra(const BitMaze &maze, int startX, int startY,
+                              int goalX, int goalY, MazeSink &sink,
+                              OpenListType openList) {
+  return searchDijkstraWith(openList, maze, startX, startY, goalX, goalY,
+                            sink, threadSearchState());
+}
+SearchResult findPathBFS(const Grid &maze, int startX, int startY, int goalX,
+                         int goalY, MazeSink &sink) {
+  return searchBFS(maze, startX, startY, goalX, goalY, sink,
+                   threadSearchState());
+}
+SearchResult findPathBFS(const BitMaze &maze, int startX, int startY,
+                         int goalX, int goalY, MazeSink &sink) {
+  return searchBFS(maze, startX, startY, goalX, goalY, sink,
+                   threadSearchState());
+}
+long findDistancesBFS(const Grid &maze, int startX, int startY,
+                      std::vector<int> &distance) {
+  return searchDistances(maze, startX, startY, distance, threadSearchState());
+}
+long findDistancesBFS(const BitMaze &maze, int startX, int startY,
+                      std::vector<int> &distance) {
+  return searchDistances(maze, startX, startY, distance, threadSearchState());
+}
+SearchResult findPathDFS(const Grid &maze, int startX, int startY, int goalX,
+                         int goalY, MazeSink &sink) {
+  return searchDFS(maze, startX, startY, goalX, goalY, sink,
+                   threadSearchState());
+}
+SearchResult findPathDFS(const BitMaze &maze, int startX, int startY,
+                         int goalX, int goalY, MazeSink &sink) {
+  return searchDFS(maze, startX, startY, goalX, goalY, sink,
+                   threadSearchState());
+}
+
+SearchResult findPathBidirectionalBFS(const Grid &maze, int startX,
+                                      int startY, int goalX, int goalY,
+                                      MazeSink &sink) {
+  return searchBidirectionalBFS(maze, startX, startY, goalX, goalY, sink,
+                                threadSearchState());
+}
+SearchResult findPathBidirectionalBFS(const BitMaze &maze, int startX,
+                                      int startY, int goalX, int goalY,
+                                      MazeSink &sink) {
+  return searchBidirectionalBFS(maze, startX, startY, goalX, goalY, sink,
+                                threadSearchState());
+}
+SearchResult findPathBidirectionalAStar(const Grid &maze, int startX,
+                                        int startY, int goalX, int goalY,
+                                        int (*heuristic)(int, int, int, int),
+                                        MazeSink &sink,
+                                        OpenListType openList) {
+  return searchBidirectionalAStarWith(openList, maze, startX, startY, goalX,
+                                      goalY, heuristic, sink,
+                                      threadSearchState());
+}
+SearchResult findPathBidirectionalAStar(const BitMaze &maze, int startX,
+                                        int startY, int goalX, int goalY,
+                                        int (*heuristic)(int, int, int, int),
+                                        MazeSink &sink,
+                                        OpenListType openList) {
+  return searchBidirectionalAStarWith(openList, maze, startX, startY, goalX,
+                                      goalY, heuristic, sink,
+                                      threadSearchState());
+}
+
+SearchResult findPathJPS(const Grid &maze, int startX, int startY, int goalX,
+                         int goalY, int (*heuristic)(int, int, int, int),
+                         MazeSink &sink, OpenListType openList) {
+  return searchJPSOn(openList, maze, nullptr, startX, startY, goalX, goalY,
+                     heuristic, sink, threadSearchState());
+}
+SearchResult findPathJPS(const BitMaze &maze, int startX, int startY,
+                         int goalX, int goalY,
+                         int (*heuristic)(int, int, int, int), MazeSink &sink,
+                         OpenListType openList) {
+  return searchJPSOn(openList, maze, nullptr, startX, startY, goalX, goalY,
+                     heuristic, sink, threadSearchState());
+}
+SearchResult findPathJPS(const Grid &maze, const JumpTable &jumps, int startX,
+                         int startY, int goalX, int goalY,
+                         int (*heuristic)(int, int, int, int), MazeSink &sink,
+                         OpenListType openList) {
+  return searchJPSOn(openList, maze, &jumps, startX, startY, goalX, goalY,
+                     heuristic, sink, threadSearchState());
+}
+SearchResult findPathJPS(const BitMaze &maze, const JumpTable &jumps,
+                         int startX, int startY, int goalX, int goalY,
+                         int (*heuristic)(int, int, int, int), MazeSink &sink,
+                         OpenListType openList) {
+  return searchJPSOn(openList, maze, &jumps, startX, startY, goalX, goalY,
+                     heuristic, sink, threadSearchState());
+}
+
+void markPath(Grid &maze, const SearchResult &result) {
+  for (size_t i = 1; i + 1 < result.path.size(); ++i)
+    maze(result.path[i].first, result.path[i].second) = PATH;
+}
+
+SolverContext::SolverContext(const Grid &maze)
+    : grid(&maze), bits(nullptr), state(new SearchState) {
+  state->begin(maze.size());
+}
+SolverContext::SolverContext(const BitMaze &maze)
+    : grid(nullptr), bits(&maze), state(new SearchState) {
+  state->begin(maze.size());
+}
+SolverContext::~SolverContext() {}
+
+SearchResult SolverContext::findPathAStar(int startX, int startY, int goalX,
+                                          int goalY,
+                                          int (*heuristic)(int, int, int, int),
+                                          MazeSink &sink,
+                                          OpenListType openList) {
+  if (grid)
+    return searchAStarWith(openList, *grid, startX, startY, goalX, goalY,
+                           heuristic, sink, *state);
+  return searchAStarWith(openList, *bits, startX, startY, goalX, goalY,
+                         heuristic, sink, *state);
+}
+SearchResult SolverContext::findPathDijkstra(int startX, int startY, int goalX,
+                                             int goalY, MazeSink &sink,
+                                             OpenListType openList) {
+  if (grid)
+    return searchDijkstraWith(openList, *grid, startX, startY, goalX, goalY,
+                              sink, *state);
+  return searchDijkstraWith(openList, *bits, startX, startY, goalX, goalY,
+                            sink, *state);
+}
+SearchResult SolverContext::findPathBFS(int startX, int startY, int goalX,
+                                        int goalY, MazeSink &sink) {
+  if (grid)
+    return searchBFS(*grid, startX, startY, goalX, goalY, sink, *state);
+  return searchBFS(*bits, startX, startY, goalX, goalY, sink, *state);
+}
+SearchResult SolverContext::findPathDFS(int startX, int startY, int goalX,
+                                        int goalY, MazeSink &sink) {
+  if (grid)
+    return searchDFS(*grid, startX, startY, goalX, goalY, sink, *state);
+  return searchDFS(*bits, startX, startY, goalX, goalY, sink, *state);
+}
+SearchResult SolverContext::findPathBidirectionalBFS(int startX, int startY,
+                                                     int goalX, int goalY,
+                                                     MazeSink &sink) {
+  if (grid)
+    return searchBidirectionalBFS(*grid, startX, startY, goalX, goalY, sink,
+                                  *state);
+  return searchBidirectionalBFS(*bits, startX, startY, goalX, goalY, sink,
+                                *state);
+}
+SearchResult SolverContext::findPathBidirectionalAStar(
+    int startX, int startY, int goalX, int goalY,
+    int (*heuristic)(int, int, int, int), MazeSink &sink,
+    OpenListType openList) {
+  if (grid)
+    return searchBidirectionalAStarWith(openList, *grid, startX, startY, goalX,
+                                        goalY, heuristic, sink, *state);
+  return searchBidirectionalAStarWith(openList, *bits, startX, startY, goalX,
+                                      goalY, heuristic, sink, *state);
+}
+SearchResult SolverContext::findPathJPS(int startX, int startY, int goalX,
+                                        int goalY,
+                                        int (*heuristic)(int, int, int, int),
+                                        MazeSink &sink,
+                                        OpenListType openList) {
+  if (grid)
+    return searchJPSOn(openList, *grid, nullptr, startX, startY, goalX, goalY,
+                       heuristic, sink, *state);
+  return searchJPSOn(openList, *bits, nullptr, startX, startY, goalX, goalY,
+                     heuristic, sink, *state);
+}
+SearchResult SolverContext::findPathJPS(const JumpTable &jumps, int startX,
+                                        int startY, int goalX, int goalY,
+                                        int (*heuristic)(int, int, int, int),
+                                        MazeSink &sink,
+                                        OpenListType openList) {
+  if (grid)
+    return searchJPSOn(openList, *grid, &jumps, startX, startY, goalX, goalY,
+                       heuristic, sink, *state);
+  return searchJPSOn(openList, *bits, &jumps, startX, startY, goalX, goalY,
+                     heuristic, sink, *state);
 }
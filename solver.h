@@ -1,17 +1,157 @@
 #ifndef MAZE_SOLVER_H
 #define MAZE_SOLVER_H
 
+#include "bitmaze.h"
+#include "grid.h"
+#include "jumptable.h"
+#include "openlist.h"
+#include "sink.h"
 #include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
-struct Cell;
+// Every solver reports the cells it visits and the final path to sink (nothing
+// is drawn by default). The maze itself is never modified, its search state
+// lives in separate arrays, so one maze can be searched from several threads
+// at once (see solveBatch in engine.h).
+
+// Dijkstra and A* take the open list to use (see openlist.h); the default
+// bucket queue suits the unit step costs of every maze here.
+
+// Outcome of a search: whether the goal was reached, the path from start to
+// goal (both inclusive, as (x, y) pairs) and the number of expanded cells
+struct SearchResult {
+  bool found = false;
+  std::vector<std::pair<int, int> > path;
+  long expanded = 0;
+};
 
 int defaultHeuristic(int x1, int y1, int x2, int y2);
-bool findPathAStar(
-    std::vector<std::vector<char>> &maze, int startX, int startY, int goalX, int goalY,
-   int (*heuristic)(int, int, int, int) = defaultHeuristic);
-bool findPathDijkstra(std::vector<std::vector<char>> &maze, int startX, int startY, int goalX, int goalY);
-bool findPathBFS(std::vector<std::vector<char>> &maze, int startX, int startY, int goalX, int goalY);
-bool findPathDFS(std::vector<std::vector<char>> &maze, int startX, int startY, int goalX, int goalY);
+SearchResult findPathAStar(
+    const Grid &maze, int startX, int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathDijkstra(const Grid &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathBFS(const Grid &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink());
+SearchResult findPathDFS(const Grid &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink());
+// Bidirectional variants: both search from the start and from the goal at
+// once and stop when the two frontiers meet. They save the most where the
+// cells within reach grow fast with distance (Prim's and Kruskal's mazes)
+// and little on the long corridors of randomizedDFS; compare
+// SearchResult::expanded.
+SearchResult findPathBidirectionalBFS(const Grid &maze, int startX, int startY,
+   int goalX, int goalY, MazeSink &sink = nullSink());
+SearchResult findPathBidirectionalAStar(
+    const Grid &maze, int startX, int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+// Jump Point Search (4-connected): A* that only stops where a shortest path
+// may turn and jumps over the straight runs in between, so open rooms cost a
+// handful of expansions instead of one per cell. Given a JumpTable built from
+// the same maze (JPS+), the jumps are read from it instead of being scanned.
+SearchResult findPathJPS(const Grid &maze, int startX, int startY, int goalX,
+   int goalY, int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathJPS(const Grid &maze, const JumpTable &jumps, int startX,
+   int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+
+// The same searches on a bit-packed maze
+SearchResult findPathAStar(
+    const BitMaze &maze, int startX, int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathDijkstra(const BitMaze &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathBFS(const BitMaze &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink());
+SearchResult findPathDFS(const BitMaze &maze, int startX, int startY, int goalX, int goalY,
+   MazeSink &sink = nullSink());
+SearchResult findPathBidirectionalBFS(const BitMaze &maze, int startX, int startY,
+   int goalX, int goalY, MazeSink &sink = nullSink());
+SearchResult findPathBidirectionalAStar(
+    const BitMaze &maze, int startX, int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathJPS(const BitMaze &maze, int startX, int startY,
+   int goalX, int goalY, int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+SearchResult findPathJPS(const BitMaze &maze, const JumpTable &jumps,
+   int startX, int startY, int goalX, int goalY,
+   int (*heuristic)(int, int, int, int) = defaultHeuristic,
+   MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+
+// Function to compute the number of steps from (startX, startY) to every
+// cell with a full breadth-first search: distance[maze.index(x, y)] is -1 for
+// walls and cells that cannot be reached. Returns the number of cells reached.
+long findDistancesBFS(const Grid &maze, int startX, int startY,
+                      std::vector<int> &distance);
+long findDistancesBFS(const BitMaze &maze, int startX, int startY,
+                      std::vector<int> &distance);
+
+// Function to draw a found path into a maze as PATH cells, leaving the start
+// and goal marks in place
+void markPath(Grid &maze, const SearchResult &result);
+
+struct SearchState;
+class BitBlocks;
+
+// The searches bound to one maze, for running many queries against it. The
+// context keeps the per-cell cost, visited and parent state between queries
+// and tells stale entries apart by a generation stamp, so a query never clears
+// the whole maze: after the first one, its cost grows with the region it
+// explores rather than with the maze size. The maze must outlive the context
+// and keep its dimensions. A context serves one query at a time.
+class SolverContext {
+public:
+  explicit SolverContext(const Grid &maze);
+  explicit SolverContext(const BitMaze &maze);
+  ~SolverContext();
+  SolverContext(const SolverContext &) = delete;
+  SolverContext &operator=(const SolverContext &) = delete;
+
+  SearchResult findPathAStar(
+      int startX, int startY, int goalX, int goalY,
+      int (*heuristic)(int, int, int, int) = defaultHeuristic,
+      MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+  SearchResult findPathDijkstra(int startX, int startY, int goalX, int goalY,
+                                MazeSink &sink = nullSink(),
+                                OpenListType openList = OPEN_BUCKET_QUEUE);
+  SearchResult findPathBFS(int startX, int startY, int goalX, int goalY,
+                           MazeSink &sink = nullSink());
+  SearchResult findPathDFS(int startX, int startY, int goalX, int goalY,
+                           MazeSink &sink = nullSink());
+  SearchResult findPathBidirectionalBFS(int startX, int startY, int goalX,
+                                        int goalY,
+                                        MazeSink &sink = nullSink());
+  SearchResult findPathBidirectionalAStar(
+      int startX, int startY, int goalX, int goalY,
+      int (*heuristic)(int, int, int, int) = defaultHeuristic,
+      MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+  // jumps, when given, must have been built from the bound maze
+  SearchResult findPathJPS(
+      int startX, int startY, int goalX, int goalY,
+      int (*heuristic)(int, int, int, int) = defaultHeuristic,
+      MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+  SearchResult findPathJPS(
+      const JumpTable &jumps, int startX, int startY, int goalX, int goalY,
+      int (*heuristic)(int, int, int, int) = defaultHeuristic,
+      MazeSink &sink = nullSink(), OpenListType openList = OPEN_BUCKET_QUEUE);
+  // Bit-parallel BFS (see bitbfs.h); blocks must have been built from the
+  // bound maze
+  SearchResult findPathBitBFS(const BitBlocks &blocks, int startX, int startY,
+                              int goalX, int goalY,
+                              MazeSink &sink = nullSink());
+
+private:
+  const Grid *grid;    // the bound maze, exactly one of grid and bits is set
+  const BitMaze *bits;
+  std::unique_ptr<SearchState> state;
+};
 
 #endif // MAZE_SOLVER_H
@@ -0,0 +1,57 @@
+#include "stream.h"
+#include "definitions.h"
+#include "generator.h"
+#include <string>
+#include <vector>
+
+// Text is handed to the stream in blocks of about this many bytes, so wide
+// and narrow mazes alike cost few write calls
+static const std::size_t STREAM_BLOCK = 1 << 20;
+
+void generateRows(int width, int height,
+                  const std::function<bool(int y, const char *row)> &emit,
+                  std::uint64_t seed) {
+  // Ensure odd dimensions
+  width |= 1;
+  height |= 1;
+
+  MazeRandom random(seed);
+  EllerRows rows(width, random);
+  std::vector<char> wall(width, WALL);
+  std::vector<char> cells(width);
+  std::vector<char> below(width);
+
+  // A single row is all border; it must not be emitted again as the last row
+  if (!emit(0, wall.data()) || height == 1)
+    return;
+  for (int y = 1; y < height - 1; y += 2) {
+    bool last = y + 2 >= height - 1;
+    rows.next(cells.data(), below.data(), last);
+    if (!emit(y, cells.data()))
+      return;
+    if (!last && !emit(y + 1, below.data()))
+      return;
+  }
+  emit(height - 1, wall.data());
+}
+
+bool streamMaze(std::ostream &out, int width, int height,
+                std::uint64_t seed) {
+  std::string block;
+  block.reserve(STREAM_BLOCK + (width | 1) + 1);
+  generateRows(
+      width, height,
+      [&](int, const char *row) {
+        block.append(row, width | 1);
+        block.push_back('\n');
+        if (block.size() >= STREAM_BLOCK) {
+          out.write(block.data(), block.size());
+          block.clear();
+        }
+        return static_cast<bool>(out);
+      },
+      seed);
+  out.write(block.data(), block.size());
+  out.flush();
+  return static_cast<bool>(out);
+}
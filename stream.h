@@ -0,0 +1,28 @@
+#ifndef MAZE_STREAM_H
+#define MAZE_STREAM_H
+
+#include "random.h"
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+// Mazes produced and handed on row by row, without ever holding the whole
+// grid: Eller's algorithm (see EllerRows) carves one row of cells at a
+// time, so only a few rows of width chars exist at any moment and the height
+// is limited by the consumer alone. A 100000 x 100000 maze needs a few
+// hundred kilobytes of memory instead of ten gigabytes.
+
+// Function to generate a width x height maze (both made odd) with Eller's
+// algorithm and pass each row to emit, top to bottom and border rows
+// included; row points to width chars that are valid during the call only.
+// Generation stops early when emit returns false.
+void generateRows(int width, int height,
+                  const std::function<bool(int y, const char *row)> &emit,
+                  std::uint64_t seed = randomSeed());
+
+// Function to write such a maze to out as text, one line per row as
+// loadMaze reads it; returns false if writing failed
+bool streamMaze(std::ostream &out, int width, int height,
+                std::uint64_t seed = randomSeed());
+
+#endif // MAZE_STREAM_H
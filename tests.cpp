@@ -0,0 +1,848 @@
+// maze_tests: checks of the generators, solvers and file formats that can be
+// rerun after any change (ctest runs them). Every check prints where it
+// failed, and the run exits with 1 if any did.
+// Temporary files are written to the working directory and removed again.
+#include "bitbfs.h"
+#include "bitmaze.h"
+#include "definitions.h"
+#include "distancefield.h"
+#include "engine.h"
+#include "generator.h"
+#include "graph.h"
+#include "grid.h"
+#include "mazefile.h"
+#include "openlist.h"
+#include "parallelbfs.h"
+#include "random.h"
+#include "sink.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "tiling.h"
+#include "treeindex.h"
+#include "utils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ++failures;                                                              \
+      std::cout << __FILE__ << ":" << __LINE__ << ": check failed: "           \
+                << #condition << std::endl;                                    \
+    }                                                                          \
+  } while (0)
+
+// Function to tell whether two mazes have the same walls
+template <class MazeA, class MazeB>
+static bool sameWalls(const MazeA &a, const MazeB &b) {
+  if (a.width() != b.width() || a.height() != b.height())
+    return false;
+  for (int y = 0; y < a.height(); ++y)
+    for (int x = 0; x < a.width(); ++x)
+      if ((a(x, y) == WALL) != (b(x, y) == WALL))
+        return false;
+  return true;
+}
+
+// Function to build an open map with the given percentage of single wall
+// cells scattered over it, so that searches have many equal paths to choose
+// from and some cells are walled in
+static Grid scatteredWalls(int width, int height, int percent,
+                           std::uint64_t seed) {
+  MazeRandom random(seed);
+  Grid maze(width, height, EMPTY);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      if (random.below(100) < percent)
+        maze(x, y) = WALL;
+  return maze;
+}
+
+// Function to tell whether a result is an unbroken path of open cells from
+// the query's start to its goal
+template <class Maze>
+static bool isValidPath(const Maze &maze, const SearchResult &result,
+                        const PathQuery &query) {
+  const std::vector<std::pair<int, int> > &path = result.path;
+  if (path.empty() ||
+      path.front() != std::make_pair(query.startX, query.startY) ||
+      path.back() != std::make_pair(query.goalX, query.goalY))
+    return false;
+  for (size_t i = 0; i < path.size(); ++i) {
+    if (maze(path[i].first, path[i].second) == WALL)
+      return false;
+    if (i > 0 && std::abs(path[i].first - path[i - 1].first) +
+                         std::abs(path[i].second - path[i - 1].second) !=
+                     1)
+      return false;
+  }
+  return true;
+}
+
+// Function to tell whether a maze is perfect: every cell at odd coordinates
+// is open and every one at even coordinates is wall, and the open cells form
+// a tree, connected with one fewer adjacent pair than cells, so there is
+// exactly one path between any two of them
+template <class Maze> static bool isPerfect(const Maze &maze) {
+  long open = 0;
+  long pairs = 0;
+  for (int y = 0; y < maze.height(); ++y) {
+    for (int x = 0; x < maze.width(); ++x) {
+      bool isOpen = maze(x, y) != WALL;
+      if (x % 2 == 1 && y % 2 == 1 && !isOpen)
+        return false;
+      if ((x % 2 == 0 && y % 2 == 0) || x == 0 || y == 0 ||
+          x == maze.width() - 1 || y == maze.height() - 1) {
+        if (isOpen)
+          return false;
+      }
+      if (!isOpen)
+        continue;
+      ++open;
+      if (maze(x + 1, y) != WALL)
+        ++pairs;
+      if (maze(x, y + 1) != WALL)
+        ++pairs;
+    }
+  }
+  std::vector<int> distance;
+  return pairs == open - 1 && findDistancesBFS(maze, 1, 1, distance) == open;
+}
+
+// Function to replace a file with the given bytes
+static void writeFile(const std::string &filename, const std::string &bytes) {
+  std::ofstream file(filename, std::ios::binary);
+  file << bytes;
+}
+
+// Function to read a whole file
+static std::string readFile(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+// Function to check that text files with rows of different widths, or with
+// line ends inside a row, are rejected by the loader and the converter
+static void testRaggedText() {
+  const char *ragged[] = {
+      "#####\n##\n##\n",             // short rows whose bytes add up
+      "#####\n#   #\n####\n",        // last row short, file ends in '\n'
+      "#####\n#   #\n####",          // last row short, no final '\n'
+      "#####\n#   #\n######\n",      // row too long
+      "#####\n\n",                   // empty row
+      "#####\n#\r  #\n",             // '\r' inside a row
+      "#####\r\n#   #\n#####\r\n",   // mixed line ends
+  };
+  for (const char *bytes : ragged) {
+    writeFile("maze_tests_ragged.txt", bytes);
+    CHECK(loadTextMaze("maze_tests_ragged.txt").empty());
+    CHECK(loadMaze("maze_tests_ragged.txt").empty());
+    CHECK(!convertMaze("maze_tests_ragged.txt", "maze_tests_ragged.bin"));
+  }
+
+  const char *whole[] = {
+      "#####\n#   #\n#####\n",
+      "#####\n#   #\n#####",
+      "#####\r\n#   #\r\n#####\r\n",
+      "#####\r\n#   #\r\n#####",
+  };
+  for (const char *bytes : whole) {
+    writeFile("maze_tests_whole.txt", bytes);
+    Grid maze = loadTextMaze("maze_tests_whole.txt");
+    CHECK(maze.width() == 5 && maze.height() == 3);
+    CHECK(maze(1, 1) == EMPTY && maze(0, 1) == WALL && maze(4, 2) == WALL);
+  }
+  std::remove("maze_tests_ragged.txt");
+  std::remove("maze_tests_ragged.bin");
+  std::remove("maze_tests_whole.txt");
+}
+
+// Function to check that mazes survive every path between the two formats,
+// for widths around the 64-bit word boundaries of the binary format
+static void testFileRoundTrips() {
+  const int widths[] = {5, 61, 62, 63, 64, 65, 127, 129, 301};
+  for (int width : widths) {
+    Grid maze =
+        generateMaze(width, 33, randomizedKruskals, nullSink(), width);
+    BitMaze bits = toBitMaze(maze);
+
+    CHECK(saveTextMaze("maze_tests.txt", maze));
+    CHECK(sameWalls(loadTextMaze("maze_tests.txt"), maze));
+    CHECK(sameWalls(loadMaze("maze_tests.txt"), maze));
+
+    CHECK(saveBinaryMaze("maze_tests.bin", maze));
+    BitMaze loaded = loadBinaryMaze("maze_tests.bin");
+    CHECK(sameWalls(loaded, maze));
+    CHECK(sameWalls(loadMaze("maze_tests.bin"), maze));
+    CHECK(saveBinaryMaze("maze_tests_bits.bin", bits));
+    CHECK(readFile("maze_tests.bin") == readFile("maze_tests_bits.bin"));
+
+    CHECK(convertMaze("maze_tests.txt", "maze_tests_converted.bin"));
+    CHECK(readFile("maze_tests.bin") == readFile("maze_tests_converted.bin"));
+    CHECK(convertMaze("maze_tests.bin", "maze_tests_converted.txt"));
+    CHECK(readFile("maze_tests.txt") == readFile("maze_tests_converted.txt"));
+
+    // Solvers run on the mapped maze as on any other
+    SearchResult a = findPathBFS(maze, 1, 1, width - 2, 31);
+    SearchResult b = findPathBFS(loaded, 1, 1, width - 2, 31);
+    CHECK(a.found && b.found && a.path.size() == b.path.size());
+
+    // Changes to a loaded maze or its copies never reach the file
+    BitMaze copy = loaded;
+    copy.set(1, 1, WALL);
+    CHECK(loaded(1, 1) == EMPTY);
+    loaded.set(1, 1, WALL);
+    CHECK(loadBinaryMaze("maze_tests.bin")(1, 1) == EMPTY);
+  }
+
+  // A binary maze with a hole in its border is refused
+  std::string bytes = readFile("maze_tests.bin");
+  bytes[32 + 8 * 5 * 4] &= ~1; // first bit of row y = 3 (padded row 4)
+  writeFile("maze_tests_damaged.bin", bytes);
+  CHECK(loadBinaryMaze("maze_tests_damaged.bin").empty());
+
+  const char *files[] = {"maze_tests.txt",           "maze_tests.bin",
+                         "maze_tests_bits.bin",      "maze_tests_damaged.bin",
+                         "maze_tests_converted.bin", "maze_tests_converted.txt"};
+  for (const char *file : files)
+    std::remove(file);
+}
+
+// Function to check that mazes too large for int indices are refused before
+// anything is allocated, and that billion-cell mazes still fit
+static void testIndexLimits() {
+  CHECK(Grid::fits(40001, 40001));
+  CHECK(BitMaze::fits(40001, 40001));
+  CHECK(!Grid::fits(50001, 50001));
+  CHECK(!BitMaze::fits(50001, 50001));
+  CHECK(!Grid::fits(2147483647, 1));
+  bool refused = false;
+  try {
+    Grid maze(50001, 50001);
+  } catch (const std::length_error &) {
+    refused = true;
+  }
+  CHECK(refused);
+  refused = false;
+  try {
+    BitMaze maze(2147483647, 3);
+  } catch (const std::length_error &) {
+    refused = true;
+  }
+  CHECK(refused);
+}
+
+// Function to check that the bit-parallel BFS finds paths as short as BFS,
+// and finds none where BFS finds none, when one context and one BitBlocks
+// serve many queries in a row (and the thread's own buffers serve the free
+// functions), on widths around the 8- and 64-cell block boundaries
+static void testBitBFS() {
+  const int widths[] = {5, 7, 8, 9, 63, 64, 65, 130};
+  for (int width : widths) {
+    Grid mazes[2] = {scatteredWalls(width, 37, 30, width),
+                     generateMaze(width | 1, 37, randomizedPrims, nullSink(),
+                                  width)};
+    for (const Grid &maze : mazes) {
+      BitMaze bits = toBitMaze(maze);
+      BitBlocks blocks(maze);
+      SolverContext context(maze);
+      SolverContext bitContext(bits);
+      std::vector<PathQuery> queries = randomQueries(maze, 40, width);
+      for (const PathQuery &q : queries) {
+        SearchResult expected =
+            findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+        SearchResult results[4] = {
+            context.findPathBitBFS(blocks, q.startX, q.startY, q.goalX,
+                                   q.goalY),
+            bitContext.findPathBitBFS(blocks, q.startX, q.startY, q.goalX,
+                                      q.goalY),
+            findPathBitBFS(bits, q.startX, q.startY, q.goalX, q.goalY,
+                           nullSink(), SIMD_SCALAR),
+            findPathBitBFS(maze, blocks, q.startX, q.startY, q.goalX, q.goalY,
+                           nullSink(), SIMD_SSE2)};
+        for (const SearchResult &result : results) {
+          CHECK(result.found == expected.found);
+          CHECK(result.path.size() == expected.path.size());
+          CHECK(!result.found || isValidPath(maze, result, q));
+        }
+        // Without a path both have reached every cell reachable from the start
+        if (!expected.found)
+          CHECK(results[0].expanded == expected.expanded);
+      }
+
+      ThreadPool pool(2);
+      std::vector<SearchResult> expected =
+          solveBatch(SOLVER_BFS, bits, queries, pool);
+      std::vector<SearchResult> batch =
+          solveBatch(SOLVER_BIT_BFS, bits, queries, pool);
+      for (size_t i = 0; i < queries.size(); ++i)
+        CHECK(batch[i].path.size() == expected[i].path.size());
+    }
+  }
+}
+
+// Function to check that JPS and JPS+ find paths exactly as short as BFS, on
+// open maps with scattered walls (where jumps have the most turn points to
+// find) and on generated mazes, with every open list and both maze types
+static void testJumpPointSearch() {
+  Grid mazes[] = {scatteredWalls(71, 53, 0, 1),
+                  scatteredWalls(71, 53, 5, 2),
+                  scatteredWalls(71, 53, 20, 3),
+                  scatteredWalls(130, 9, 35, 4),
+                  generateMaze(71, 53, recursiveDivision, nullSink(), 5),
+                  generateMaze(71, 53, randomizedDFS, nullSink(), 6),
+                  generateMaze(71, 53, randomizedEllers, nullSink(), 7)};
+  const OpenListType openLists[] = {OPEN_BINARY_HEAP, OPEN_QUAD_HEAP,
+                                    OPEN_BUCKET_QUEUE, OPEN_INDEXED_HEAP};
+  int seed = 0;
+  for (const Grid &maze : mazes) {
+    BitMaze bits = toBitMaze(maze);
+    JumpTable jumps(maze);
+    JumpTable bitJumps(bits);
+    SolverContext context(maze);
+    std::vector<PathQuery> queries = randomQueries(maze, 60, ++seed);
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const PathQuery &q = queries[i];
+      OpenListType openList = openLists[i % 4];
+      SearchResult expected =
+          findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+      SearchResult results[4] = {
+          findPathJPS(maze, q.startX, q.startY, q.goalX, q.goalY,
+                      defaultHeuristic, nullSink(), openList),
+          findPathJPS(bits, q.startX, q.startY, q.goalX, q.goalY,
+                      defaultHeuristic, nullSink(), openList),
+          context.findPathJPS(jumps, q.startX, q.startY, q.goalX, q.goalY,
+                              defaultHeuristic, nullSink(), openList),
+          findPathJPS(bits, bitJumps, q.startX, q.startY, q.goalX, q.goalY,
+                      defaultHeuristic, nullSink(), openList)};
+      for (const SearchResult &result : results) {
+        CHECK(result.found == expected.found);
+        CHECK(result.path.size() == expected.path.size());
+        CHECK(!result.found || isValidPath(maze, result, q));
+      }
+    }
+  }
+}
+
+// Function to check searches on a JunctionGraph against BFS on the maze:
+// Dijkstra and A* always match its path length; graph BFS matches it in
+// perfect mazes and otherwise still finds a path exactly when one exists.
+// Then checks that filling dead ends keeps the shortest path.
+static void testJunctionGraph() {
+  // A corridor that closes on itself, with no junction on it
+  Grid ring(9, 7, WALL);
+  for (int x = 1; x <= 7; ++x)
+    ring(x, 1) = ring(x, 5) = EMPTY;
+  for (int y = 1; y <= 5; ++y)
+    ring(1, y) = ring(7, y) = EMPTY;
+
+  struct Case {
+    Grid maze;
+    bool perfect;
+  };
+  Case cases[] = {
+      {generateMaze(61, 41, randomizedDFS, nullSink(), 1), true},
+      {generateMaze(61, 41, randomizedKruskals, nullSink(), 2), true},
+      {generateMaze(61, 41, randomizedPrims, nullSink(), 3), true},
+      {generateMaze(61, 41, randomizedWilsons, nullSink(), 4), true},
+      {scatteredWalls(61, 41, 25, 5), false},
+      {scatteredWalls(61, 41, 40, 6), false},
+      {ring, false}};
+  int seed = 0;
+  for (const Case &c : cases) {
+    const Grid &maze = c.maze;
+    BitMaze bits = toBitMaze(maze);
+    JunctionGraph graph(maze);
+    JunctionGraph bitGraph(bits);
+    CHECK(graph.nodeCount() == bitGraph.nodeCount());
+    CHECK(graph.edgeCount() == bitGraph.edgeCount());
+    CHECK(graph.nodeCount() <= graph.openCells());
+
+    std::vector<PathQuery> queries = randomQueries(maze, 60, ++seed);
+    // Start and goal on the same cell and inside the same corridor
+    PathQuery same = {queries[0].startX, queries[0].startY,
+                      queries[0].startX, queries[0].startY};
+    queries.push_back(same);
+    for (const PathQuery &q : queries) {
+      SearchResult expected =
+          findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+      SearchResult shortest[3] = {
+          findPathDijkstra(graph, q.startX, q.startY, q.goalX, q.goalY),
+          findPathAStar(graph, q.startX, q.startY, q.goalX, q.goalY),
+          findPathAStar(bitGraph, q.startX, q.startY, q.goalX, q.goalY)};
+      for (const SearchResult &result : shortest) {
+        CHECK(result.found == expected.found);
+        CHECK(result.path.size() == expected.path.size());
+        CHECK(!result.found || isValidPath(maze, result, q));
+      }
+      SearchResult fewestNodes =
+          findPathBFS(graph, q.startX, q.startY, q.goalX, q.goalY);
+      CHECK(fewestNodes.found == expected.found);
+      CHECK(!fewestNodes.found || isValidPath(maze, fewestNodes, q));
+      if (c.perfect)
+        CHECK(fewestNodes.path.size() == expected.path.size());
+      else
+        CHECK(fewestNodes.path.size() >= expected.path.size());
+
+      if (!expected.found)
+        continue;
+      std::vector<std::pair<int, int> > keep;
+      keep.push_back(std::make_pair(q.startX, q.startY));
+      keep.push_back(std::make_pair(q.goalX, q.goalY));
+      Grid filled = maze;
+      BitMaze bitsFilled = bits;
+      long count = fillDeadEnds(filled, keep);
+      CHECK(fillDeadEnds(bitsFilled, keep) == count);
+      CHECK(sameWalls(filled, bitsFilled));
+      SearchResult after =
+          findPathBFS(filled, q.startX, q.startY, q.goalX, q.goalY);
+      CHECK(after.found && after.path.size() == expected.path.size());
+      // In a perfect maze nothing but the path is left open
+      if (c.perfect)
+        CHECK(count + static_cast<long>(expected.path.size()) ==
+              graph.openCells());
+    }
+  }
+}
+
+// Function to check that every generator carves a perfect maze, into a Grid
+// and into a BitMaze alike, for small, narrow and word-boundary sizes, and
+// that the tiled generators stitch perfect tiles into a perfect maze
+static void testGenerators() {
+  struct Generator {
+    void (*grid)(Grid &, MazeRandom &, MazeSink &);
+    void (*bits)(BitMaze &, MazeRandom &, MazeSink &);
+  };
+  const Generator generators[] = {
+      {randomizedDFS, randomizedDFS},
+      {randomizedPrims, randomizedPrims},
+      {randomizedKruskals, randomizedKruskals},
+      {recursiveDivision, recursiveDivision},
+      {randomizedEllers, randomizedEllers},
+      {randomizedWilsons, randomizedWilsons},
+      {randomizedAldousBroder, randomizedAldousBroder}};
+  const int sizes[][2] = {{5, 5}, {3, 41}, {41, 3}, {63, 9}, {65, 65},
+                          {129, 41}};
+  for (const Generator &generator : generators) {
+    for (const auto &size : sizes) {
+      for (std::uint64_t seed = 1; seed <= 3; ++seed) {
+        Grid maze = generateMaze(size[0], size[1], generator.grid,
+                                 nullSink(), seed);
+        BitMaze bits = generateBitMaze(size[0], size[1], generator.bits,
+                                       nullSink(), seed);
+        CHECK(isPerfect(maze));
+        CHECK(isPerfect(bits));
+      }
+    }
+  }
+
+  // Dimensions are rounded up to odd ones; below 2 no cell is left
+  for (const Generator &generator : generators) {
+    const int lengths[] = {1, 2, 5, 9};
+    for (int length : lengths) {
+      CHECK(generateMaze(1, length, generator.grid, nullSink(), 1).empty());
+      CHECK(generateMaze(length, 1, generator.grid, nullSink(), 1).empty());
+      CHECK(generateBitMaze(1, length, generator.bits, nullSink(), 1).empty());
+      CHECK(generateBitMaze(length, 0, generator.bits, nullSink(), 1).empty());
+      CHECK(generateMaze(-4, length, generator.grid, nullSink(), 1).empty());
+      if (length == 1)
+        continue;
+      Grid narrow = generateMaze(2, length, generator.grid, nullSink(), 1);
+      CHECK(narrow.width() == 3 && narrow.height() == (length | 1));
+      CHECK(isPerfect(narrow));
+      CHECK(isPerfect(
+          generateBitMaze(length, 2, generator.bits, nullSink(), 1)));
+    }
+  }
+
+  // The DFS carver picks its direction from a table over the open
+  // directions, so run it over many seeds to reach every entry
+  for (std::uint64_t seed = 1; seed <= 200; ++seed)
+    CHECK(isPerfect(generateMaze(31, 21, randomizedDFS, nullSink(), seed)));
+
+  // Opening any wall between two cells of a perfect maze makes a loop
+  Grid loop = generateMaze(31, 21, randomizedDFS, nullSink(), 1);
+  for (int x = 1; x < 30 && isPerfect(loop); x += 2)
+    if (loop(x, 10) == WALL)
+      loop(x, 10) = EMPTY;
+  CHECK(!isPerfect(loop));
+
+  ThreadPool one(1);
+  ThreadPool two(2);
+  for (const Generator &generator : generators) {
+    Grid maze = generateTiledMaze(101, 77, generator.grid, two, 9, 16);
+    CHECK(isPerfect(maze));
+    CHECK(sameWalls(maze,
+                    generateTiledMaze(101, 77, generator.grid, one, 9, 16)));
+    CHECK(sameWalls(maze,
+                    generateTiledBitMaze(101, 77, generator.grid, two, 9, 16)));
+  }
+}
+
+// Function to check that the parallel BFS gives exactly the distances of the
+// serial one, on a corridor maze and on open maps (where layers get wide
+// enough to go parallel and bottom-up), on one, two and four threads, and
+// that a wall as the start reaches nothing
+static void testParallelBFS() {
+  Grid mazes[] = {generateMaze(301, 201, randomizedDFS, nullSink(), 1),
+                  scatteredWalls(301, 201, 0, 2),
+                  scatteredWalls(301, 201, 30, 3)};
+  mazes[2](0, 0) = WALL;
+  const int threads[] = {1, 2, 4};
+  for (const Grid &maze : mazes) {
+    BitMaze bits = toBitMaze(maze);
+    std::vector<PathQuery> starts = randomQueries(maze, 3, 4);
+    // (0, 0) is a wall on all of them but the open map
+    PathQuery wall = {0, 0, 0, 0};
+    starts.push_back(wall);
+    for (int count : threads) {
+      ThreadPool pool(count);
+      for (const PathQuery &q : starts) {
+        std::vector<int> expected, distance, bitDistance;
+        long reached = findDistancesBFS(maze, q.startX, q.startY, expected);
+        CHECK(parallelDistances(maze, q.startX, q.startY, pool, distance) ==
+              reached);
+        CHECK(distance == expected);
+        CHECK(parallelDistances(bits, q.startX, q.startY, pool,
+                                bitDistance) == reached);
+        std::vector<int> bitExpected;
+        findDistancesBFS(bits, q.startX, q.startY, bitExpected);
+        CHECK(bitDistance == bitExpected);
+      }
+    }
+  }
+}
+
+// Function to check the distance cache: fields agree with BFS, sources
+// outside the maze do not alias cells inside it, and a saved cache loads
+// back unchanged while files of other mazes, truncated files and files with
+// a corrupt field count are refused
+static void testDistanceCache() {
+  Grid maze = generateMaze(41, 31, randomizedPrims, nullSink(), 1);
+  BitMaze bits = toBitMaze(maze);
+  DistanceCache cache(maze);
+  std::vector<PathQuery> queries = randomQueries(maze, 20, 2);
+  std::vector<std::pair<int, int> > sources;
+  for (const PathQuery &q : queries)
+    sources.push_back(std::make_pair(q.goalX, q.goalY));
+  ThreadPool pool(2);
+  cache.build(sources, pool);
+  for (const PathQuery &q : queries) {
+    SearchResult expected =
+        findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+    const DistanceField &field = cache.field(q.goalX, q.goalY);
+    CHECK(field.distance(q.startX, q.startY) + 1 ==
+          static_cast<int>(expected.path.size()));
+    CHECK(field.findPath(q.startX, q.startY).path.size() ==
+          expected.path.size());
+  }
+
+  // (width, 0) used to share its key with (0, 1)
+  int cached = cache.size();
+  const DistanceField &outside = cache.field(maze.width(), 0);
+  CHECK(!cache.contains(maze.width(), 0) && !cache.contains(-1, 3));
+  CHECK(outside.distance(1, 1) == -1 && outside.reachedCells() == 0);
+  CHECK(cache.size() == cached);
+  CHECK(cache.field(1, 1).distance(1, 1) == 0);
+
+  CHECK(cache.save("maze_tests.dist"));
+  DistanceCache loaded(bits);
+  CHECK(loaded.load("maze_tests.dist"));
+  CHECK(loaded.size() == cache.size());
+  for (const std::pair<int, int> &source : sources) {
+    CHECK(loaded.contains(source.first, source.second));
+    const DistanceField &a = cache.field(source.first, source.second);
+    const DistanceField &b = loaded.field(source.first, source.second);
+    CHECK(a.reachedCells() == b.reachedCells());
+    for (int y = 0; y < maze.height(); ++y)
+      for (int x = 0; x < maze.width(); ++x)
+        CHECK(a.distance(x, y) == b.distance(x, y));
+  }
+
+  // Same size, different walls
+  Grid other = generateMaze(41, 31, randomizedPrims, nullSink(), 2);
+  DistanceCache otherCache(other);
+  CHECK(!otherCache.load("maze_tests.dist"));
+  CHECK(otherCache.size() == 0);
+
+  std::string bytes = readFile("maze_tests.dist");
+  writeFile("maze_tests_damaged.dist", bytes.substr(0, bytes.size() - 4));
+  DistanceCache truncated(maze);
+  CHECK(!truncated.load("maze_tests_damaged.dist"));
+  CHECK(truncated.size() == 0);
+  // A field count of 2^31 - 1 must be refused before anything is allocated
+  bytes[20] = bytes[21] = bytes[22] = '\xff';
+  bytes[23] = '\x7f';
+  writeFile("maze_tests_damaged.dist", bytes);
+  CHECK(!truncated.load("maze_tests_damaged.dist"));
+  CHECK(truncated.size() == 0);
+  std::remove("maze_tests.dist");
+  std::remove("maze_tests_damaged.dist");
+}
+
+// Function to push and pop the same entries on an open list as a sorted
+// multiset does, with pushes interleaved with pops as in Dijkstra: new keys
+// are never below the last key popped but may lie far ahead (which grows the
+// bucket ring). Returns whether every popped key was the smallest queued.
+template <class OpenList> static bool popsInOrder(OpenList &open) {
+  bool ordered = true;
+  for (int round = 0; round < 2; ++round) { // the second run reuses the list
+    MazeRandom random(round + 1);
+    std::multiset<int> expected;
+    open.reset(5000);
+    // The first key is the smallest, as the start's is in a search
+    int last = random.below(10);
+    int index = 0;
+    open.push(last, index++);
+    expected.insert(last);
+    for (int step = 0; step < 4000; ++step) {
+      if (index < 5000 && (expected.empty() || random.below(3) != 0)) {
+        int ahead = random.below(20) == 0 ? 300 + random.below(2000)
+                                          : random.below(8);
+        open.push(last + ahead, index++);
+        expected.insert(last + ahead);
+      } else if (!open.empty()) {
+        int key = open.minKey();
+        OpenEntry entry = open.pop();
+        ordered = ordered && key == *expected.begin() &&
+                  entry.key == *expected.begin();
+        expected.erase(expected.begin());
+        last = entry.key;
+      }
+      ordered = ordered && open.size() == expected.size() &&
+                open.empty() == expected.empty();
+    }
+    while (!open.empty() && !expected.empty()) {
+      OpenEntry entry = open.pop();
+      ordered = ordered && entry.key == *expected.begin();
+      expected.erase(expected.begin());
+    }
+    ordered = ordered && open.empty() && expected.empty();
+  }
+  return ordered;
+}
+
+// Function to check the four open lists directly: they pop keys in the same
+// order, and the indexed heap keeps one entry per cell with its lowest key
+static void testOpenLists() {
+  BinaryHeap binaryHeap;
+  QuadHeap quadHeap;
+  BucketQueue bucketQueue;
+  IndexedHeap indexedHeap;
+  CHECK(popsInOrder(binaryHeap));
+  CHECK(popsInOrder(quadHeap));
+  CHECK(popsInOrder(bucketQueue));
+  CHECK(popsInOrder(indexedHeap));
+
+  indexedHeap.reset(10);
+  indexedHeap.push(9, 3);
+  indexedHeap.push(5, 4);
+  indexedHeap.push(7, 3); // lowers the key of 3
+  indexedHeap.push(8, 4); // ignored, 4 is queued at 5 already
+  CHECK(indexedHeap.size() == 2);
+  OpenEntry first = indexedHeap.pop();
+  OpenEntry second = indexedHeap.pop();
+  CHECK(first.key == 5 && first.index == 4);
+  CHECK(second.key == 7 && second.index == 3);
+  CHECK(indexedHeap.empty());
+}
+
+// Function to check the bidirectional searches against BFS. On loopy maps
+// the two frontiers meet on many cells, and stopping at the first meeting
+// instead of the best one would give paths that are too long.
+static void testBidirectional() {
+  // Knock about a third of the walls out of a perfect maze to make loops
+  Grid braided = generateMaze(61, 41, randomizedPrims, nullSink(), 7);
+  MazeRandom random(8);
+  for (int y = 1; y < braided.height() - 1; ++y)
+    for (int x = 1; x < braided.width() - 1; ++x)
+      if ((x + y) % 2 == 1 && random.below(3) == 0)
+        braided(x, y) = EMPTY;
+  Grid mazes[] = {generateMaze(61, 41, randomizedDFS, nullSink(), 1),
+                  generateMaze(61, 41, randomizedKruskals, nullSink(), 2),
+                  braided,
+                  scatteredWalls(61, 41, 0, 3),
+                  scatteredWalls(61, 41, 15, 4),
+                  scatteredWalls(61, 41, 35, 5),
+                  scatteredWalls(8, 120, 25, 6)};
+  const OpenListType openLists[] = {OPEN_BINARY_HEAP, OPEN_QUAD_HEAP,
+                                    OPEN_BUCKET_QUEUE, OPEN_INDEXED_HEAP};
+  int seed = 0;
+  for (const Grid &maze : mazes) {
+    BitMaze bits = toBitMaze(maze);
+    SolverContext context(maze);
+    std::vector<PathQuery> queries = randomQueries(maze, 80, ++seed);
+    PathQuery same = {queries[0].startX, queries[0].startY,
+                      queries[0].startX, queries[0].startY};
+    queries.push_back(same);
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const PathQuery &q = queries[i];
+      OpenListType openList = openLists[i % 4];
+      SearchResult expected =
+          findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+      SearchResult results[4] = {
+          findPathBidirectionalBFS(maze, q.startX, q.startY, q.goalX,
+                                   q.goalY),
+          context.findPathBidirectionalBFS(q.startX, q.startY, q.goalX,
+                                           q.goalY),
+          findPathBidirectionalAStar(bits, q.startX, q.startY, q.goalX,
+                                     q.goalY, defaultHeuristic, nullSink(),
+                                     openList),
+          context.findPathBidirectionalAStar(q.startX, q.startY, q.goalX,
+                                             q.goalY, defaultHeuristic,
+                                             nullSink(), openList)};
+      for (const SearchResult &result : results) {
+        CHECK(result.found == expected.found);
+        CHECK(result.path.size() == expected.path.size());
+        CHECK(!result.found || isValidPath(maze, result, q));
+      }
+    }
+  }
+}
+
+// Function to check the tree index against BFS: on perfect mazes from every
+// generator, distance() and findPath() give the unique path; on a maze with
+// loops isTree() is false, its paths are still valid, and the tree solver of
+// solveBatch falls back to BFS
+static void testTreeIndex() {
+  void (*generators[])(Grid &, MazeRandom &, MazeSink &) = {
+      randomizedDFS,     randomizedPrims,  randomizedKruskals,
+      recursiveDivision, randomizedEllers, randomizedWilsons,
+      randomizedAldousBroder};
+  std::uint64_t seed = 0;
+  for (auto generator : generators) {
+    Grid maze = generateMaze(61, 41, generator, nullSink(), ++seed);
+    // Wall the top left cell off, so the index covers several trees
+    maze(2, 1) = maze(1, 2) = WALL;
+    TreeIndex index(maze);
+    TreeIndex bitIndex(toBitMaze(maze));
+    CHECK(index.isTree() && bitIndex.isTree());
+    std::vector<PathQuery> queries = randomQueries(maze, 80, seed);
+    PathQuery corner = {1, 1, 59, 39};
+    queries.push_back(corner);
+    for (const PathQuery &q : queries) {
+      SearchResult expected =
+          findPathBFS(maze, q.startX, q.startY, q.goalX, q.goalY);
+      int steps = static_cast<int>(expected.path.size()) - 1;
+      CHECK(index.distance(q.startX, q.startY, q.goalX, q.goalY) == steps);
+      CHECK(bitIndex.distance(q.goalX, q.goalY, q.startX, q.startY) == steps);
+      SearchResult result =
+          index.findPath(q.startX, q.startY, q.goalX, q.goalY);
+      CHECK(result.found == expected.found);
+      CHECK(result.path.size() == expected.path.size());
+      CHECK(!result.found || isValidPath(maze, result, q));
+    }
+    CHECK(index.distance(0, 0, 1, 3) == -1);
+  }
+
+  // Opening a whole row of walls closes loops across it
+  Grid loops = generateMaze(61, 41, randomizedDFS, nullSink(), 9);
+  for (int x = 2; x < 60; x += 2)
+    loops(x, 21) = EMPTY;
+  TreeIndex index(loops);
+  CHECK(!index.isTree());
+  std::vector<PathQuery> queries = randomQueries(loops, 80, 10);
+  ThreadPool pool(2);
+  std::vector<SearchResult> batch =
+      solveBatch(SOLVER_TREE_INDEX, loops, queries, pool);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    const PathQuery &q = queries[i];
+    SearchResult expected =
+        findPathBFS(loops, q.startX, q.startY, q.goalX, q.goalY);
+    SearchResult result = index.findPath(q.startX, q.startY, q.goalX, q.goalY);
+    CHECK(result.found && isValidPath(loops, result, q));
+    CHECK(result.path.size() >= expected.path.size());
+    CHECK(batch[i].path.size() == expected.path.size());
+  }
+}
+
+// Function to check that random queries land on open cells only, and that
+// a maze without any gets no queries instead of an endless search for one
+static void testRandomQueries() {
+  CHECK(randomQueries(Grid(9, 7, WALL), 10).empty());
+  CHECK(randomQueries(Grid(), 10).empty());
+  Grid single(9, 7, WALL);
+  single(4, 3) = EMPTY;
+  std::vector<PathQuery> queries = randomQueries(single, 10);
+  CHECK(queries.size() == 10);
+  for (const PathQuery &q : queries)
+    CHECK(q.startX == 4 && q.startY == 3 && q.goalX == 4 && q.goalY == 3);
+}
+
+// Function to check that a seed fixes the maze: the same seed gives the same
+// maze on every run of every generator, on both maze types and through
+// runHeadless, different seeds give different mazes, and tiled generation
+// does not depend on the number of threads
+static void testSeeds() {
+  const GeneratorType generators[] = {
+      GENERATOR_DFS,      GENERATOR_PRIMS,   GENERATOR_DIVISION,
+      GENERATOR_KRUSKALS, GENERATOR_ELLERS,  GENERATOR_WILSONS,
+      GENERATOR_ALDOUS_BRODER};
+  ThreadPool one(1);
+  ThreadPool two(2);
+  ThreadPool four(4);
+  for (GeneratorType generator : generators) {
+    Grid first = generateMazeWith(generator, 51, 37, nullSink(), 42);
+    Grid again = generateMazeWith(generator, 51, 37, nullSink(), 42);
+    Grid other = generateMazeWith(generator, 51, 37, nullSink(), 43);
+    CHECK(sameWalls(first, again));
+    CHECK(!sameWalls(first, other));
+    CHECK(sameWalls(runHeadless(51, 37, generator, SOLVER_BFS,
+                                OPEN_BUCKET_QUEUE, PreprocessOptions(), 42)
+                        .maze,
+                    first));
+
+    void (*carve)(Grid &, MazeRandom &, MazeSink &) = carverFor(generator);
+    Grid tiled = generateTiledMaze(301, 201, carve, one, 42, 64);
+    CHECK(sameWalls(tiled, generateTiledMaze(301, 201, carve, two, 42, 64)));
+    CHECK(sameWalls(tiled, generateTiledMaze(301, 201, carve, four, 42, 64)));
+    CHECK(sameWalls(tiled,
+                    generateTiledBitMaze(301, 201, carve, four, 42, 64)));
+    CHECK(!sameWalls(tiled, generateTiledMaze(301, 201, carve, two, 43, 64)));
+  }
+
+  void (*bitCarvers[])(BitMaze &, MazeRandom &, MazeSink &) = {
+      randomizedDFS,     randomizedPrims,  randomizedKruskals,
+      recursiveDivision, randomizedEllers, randomizedWilsons,
+      randomizedAldousBroder};
+  for (auto carve : bitCarvers) {
+    BitMaze first = generateBitMaze(51, 37, carve, nullSink(), 42);
+    CHECK(sameWalls(first, generateBitMaze(51, 37, carve, nullSink(), 42)));
+    CHECK(!sameWalls(first, generateBitMaze(51, 37, carve, nullSink(), 43)));
+  }
+}
+
+int main() {
+  testRaggedText();
+  testFileRoundTrips();
+  testIndexLimits();
+  testBitBFS();
+  testJumpPointSearch();
+  testJunctionGraph();
+  testGenerators();
+  testParallelBFS();
+  testDistanceCache();
+  testOpenLists();
+  testBidirectional();
+  testTreeIndex();
+  testRandomQueries();
+  testSeeds();
+
+  if (failures > 0) {
+    std::cout << failures << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "All checks passed" << std::endl;
+  return 0;
+}
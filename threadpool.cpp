@@ -0,0 +1,81 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads)
+    : task(nullptr), count(0), chunk(1), next(0), generation(0), busy(0),
+      stopping(false) {
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int worker = 1; worker < threads; ++worker)
+    workers.emplace_back(&ThreadPool::workerLoop, this, worker);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+void ThreadPool::parallelFor(int count,
+                             const std::function<void(int, int)> &task,
+                             int chunk) {
+  if (count <= 0)
+    return;
+  if (workers.empty()) {
+    for (int index = 0; index < count; ++index)
+      task(0, index);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    this->count = count;
+    this->chunk = std::max(1, chunk);
+    next = 0;
+    busy = workers.size();
+    ++generation;
+  }
+  wake.notify_all();
+
+  runChunks(0);
+
+  // The task must stay alive until every worker has let go of it
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return busy == 0; });
+}
+
+void ThreadPool::workerLoop(int worker) {
+  unsigned long seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+    }
+    runChunks(worker);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--busy == 0)
+        done.notify_one();
+    }
+  }
+}
+
+// Function to claim chunks of the current loop until none are left
+void ThreadPool::runChunks(int worker) {
+  for (;;) {
+    int begin = next.fetch_add(chunk);
+    if (begin >= count)
+      return;
+    int end = std::min(begin + chunk, count);
+    for (int index = begin; index < end; ++index)
+      (*task)(worker, index);
+  }
+}
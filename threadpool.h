@@ -0,0 +1,54 @@
+#ifndef MAZE_THREADPOOL_H
+#define MAZE_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. The calling thread
+// takes part as worker 0, so a pool of size 1 starts no threads at all and
+// runs everything inline. Indices are handed out dynamically in chunks, which
+// keeps the workers busy when items differ a lot in cost (e.g. path queries of
+// different lengths).
+class ThreadPool {
+public:
+  // threads <= 0 uses one worker per hardware thread
+  explicit ThreadPool(int threads = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of workers, including the calling thread
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Function to run task(worker, index) for every index in [0, count) and
+  // wait until all are done. worker is in [0, size()) and identifies the
+  // thread, so tasks can keep per-worker scratch. Not reentrant.
+  void parallelFor(int count,
+                   const std::function<void(int worker, int index)> &task,
+                   int chunk = 1);
+
+private:
+  void workerLoop(int worker);
+  void runChunks(int worker);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake; // a new loop was posted, or shutdown
+  std::condition_variable done; // the last worker left the current loop
+
+  // The loop being run; written under mutex before generation is bumped
+  const std::function<void(int, int)> *task;
+  int count;
+  int chunk;
+  std::atomic<int> next;    // first index not handed out yet
+  unsigned long generation; // number of loops posted so far
+  int busy;                 // background workers still inside the loop
+  bool stopping;
+};
+
+#endif // MAZE_THREADPOOL_H
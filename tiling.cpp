@@ -0,0 +1,128 @@
+#include "tiling.h"
+#include "definitions.h"
+#include "generator.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Function to derive the seed of one tile (splitmix64 finalizer over the
+// seed and the tile number), so neighbouring tiles draw unrelated sequences
+static std::uint64_t tileSeed(std::uint64_t seed, int tile) {
+  std::uint64_t z =
+      seed ^ (static_cast<std::uint64_t>(tile) + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Function to copy the inside of a carved tile to the maze, with the tile's
+// top left corner (a boundary wall) at (left, top)
+static void copyTile(const Grid &tile, Grid &maze, int left, int top) {
+  for (int y = 1; y < tile.height() - 1; ++y)
+    std::copy(tile.row(y) + 1, tile.row(y) + tile.width() - 1,
+              maze.row(top + y) + left + 1);
+}
+static void copyTile(const Grid &tile, BitMaze &maze, int left, int top) {
+  // The maze starts out all walls, so only openings need writing
+  for (int y = 1; y < tile.height() - 1; ++y) {
+    const char *row = tile.row(y);
+    for (int x = 1; x < tile.width() - 1; ++x) {
+      if (row[x] != WALL)
+        maze.set(left + x, top + y, EMPTY);
+    }
+  }
+}
+
+template <class Maze>
+static void carveTiled(Maze &maze,
+                       void (*carveMaze)(Grid &, MazeRandom &, MazeSink &),
+                       ThreadPool &pool, std::uint64_t seed, int tileCells) {
+  int cellsX = maze.width() / 2;
+  int cellsY = maze.height() / 2;
+  int tilesX = (cellsX + tileCells - 1) / tileCells;
+  int tilesY = (cellsY + tileCells - 1) / tileCells;
+
+  // Workers take whole bands of tiles. Bands write disjoint rows, which never
+  // share a word of a BitMaze, and the walls between them are left alone.
+  std::vector<Grid> scratch(pool.size());
+  pool.parallelFor(tilesY, [&](int worker, int band) {
+    Grid &tile = scratch[worker];
+    int rows = std::min(tileCells, cellsY - band * tileCells);
+    for (int column = 0; column < tilesX; ++column) {
+      int columns = std::min(tileCells, cellsX - column * tileCells);
+      if (tile.width() != 2 * columns + 1 || tile.height() != 2 * rows + 1)
+        tile = Grid(2 * columns + 1, 2 * rows + 1, WALL);
+      else
+        tile.fill(WALL);
+      MazeRandom random(tileSeed(seed, band * tilesX + column));
+      carveMaze(tile, random, nullSink());
+      copyTile(tile, maze, 2 * column * tileCells, 2 * band * tileCells);
+    }
+  });
+
+  // Walls between neighbouring tiles, as (tile, joins the tile below)
+  std::vector<std::pair<int, bool> > walls;
+  for (int row = 0; row < tilesY; ++row) {
+    for (int column = 0; column < tilesX; ++column) {
+      int tile = row * tilesX + column;
+      if (column + 1 < tilesX)
+        walls.push_back(std::make_pair(tile, false));
+      if (row + 1 < tilesY)
+        walls.push_back(std::make_pair(tile, true));
+    }
+  }
+
+  // Kruskal's algorithm over the tiles: walls in random order, each one
+  // opened if the tiles on both sides are not connected yet
+  MazeRandom random(seed);
+  for (int i = walls.size() - 1; i > 0; --i)
+    std::swap(walls[i], walls[random.below(i + 1)]);
+  UnionFind tiles(tilesX * tilesY);
+  for (const std::pair<int, bool> &wall : walls) {
+    int tile = wall.first;
+    int next = wall.second ? tile + tilesX : tile + 1;
+    if (tiles.find(tile) == tiles.find(next))
+      continue;
+    tiles.unite(tile, next);
+
+    int row = tile / tilesX;
+    int column = tile % tilesX;
+    if (wall.second) {
+      // Door in the wall row below, at one of the tile's cell columns
+      int columns = std::min(tileCells, cellsX - column * tileCells);
+      int x = 2 * (column * tileCells + random.below(columns)) + 1;
+      maze.set(x, 2 * (row + 1) * tileCells, EMPTY);
+    } else {
+      // Door in the wall column to the right, at one of the tile's cell rows
+      int rows = std::min(tileCells, cellsY - row * tileCells);
+      int y = 2 * (row * tileCells + random.below(rows)) + 1;
+      maze.set(2 * (column + 1) * tileCells, y, EMPTY);
+    }
+  }
+}
+
+Grid generateTiledMaze(int width, int height,
+                       void (*carveMaze)(Grid &, MazeRandom &, MazeSink &),
+                       ThreadPool &pool, std::uint64_t seed, int tileCells) {
+  // Ensure odd dimensions
+  width |= 1;
+  height |= 1;
+
+  Grid maze(width, height, WALL);
+  carveTiled(maze, carveMaze, pool, seed, std::max(1, tileCells));
+  return maze;
+}
+
+BitMaze generateTiledBitMaze(int width, int height,
+                             void (*carveMaze)(Grid &, MazeRandom &,
+                                               MazeSink &),
+                             ThreadPool &pool, std::uint64_t seed,
+                             int tileCells) {
+  // Ensure odd dimensions
+  width |= 1;
+  height |= 1;
+
+  BitMaze maze(width, height, WALL);
+  carveTiled(maze, carveMaze, pool, seed, std::max(1, tileCells));
+  return maze;
+}
@@ -0,0 +1,35 @@
+#ifndef MAZE_TILING_H
+#define MAZE_TILING_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "random.h"
+#include "sink.h"
+#include "threadpool.h"
+#include <cstdint>
+
+// Generation of very large mazes on the threads of a pool. The maze is cut
+// into square tiles of tileCells x tileCells cells, which share their
+// boundary walls. Every tile is carved on its own by carveMaze, concurrently,
+// with a random generator derived from the seed and the tile's position.
+// A stitching pass then joins the tiles with a random spanning tree of the
+// tile grid (Kruskal's algorithm with UnionFind), opening one door in the
+// wall between each joined pair. As long as carveMaze leaves a perfect maze
+// in each tile, which all generators in generator.h do, the result is a
+// perfect maze again: one path between any two cells.
+//
+// Tiles are carved into small Grids and copied out, so the Grid carvers serve
+// both result types. Nothing is reported to a sink, and the result depends
+// on seed and tileCells but not on the number of threads.
+Grid generateTiledMaze(int width, int height,
+                       void (*carveMaze)(Grid &, MazeRandom &, MazeSink &),
+                       ThreadPool &pool, std::uint64_t seed = randomSeed(),
+                       int tileCells = 256);
+BitMaze generateTiledBitMaze(int width, int height,
+                             void (*carveMaze)(Grid &, MazeRandom &,
+                                               MazeSink &),
+                             ThreadPool &pool,
+                             std::uint64_t seed = randomSeed(),
+                             int tileCells = 256);
+
+#endif // MAZE_TILING_H
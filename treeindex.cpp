@@ -0,0 +1,169 @@
+#include "treeindex.h"
+#include "definitions.h"
+#include <algorithm>
+#include <utility>
+
+// Nodes per block of the range-minimum table. Ranges inside a block or two
+// are scanned directly, longer ones read the table for their whole blocks,
+// which keeps the table at (nodes / 32) * log(nodes / 32) entries.
+static const int BLOCK_SHIFT = 5;
+static const int BLOCK_SIZE = 1 << BLOCK_SHIFT;
+
+TreeIndex::TreeIndex(const Grid &maze) { build(maze); }
+TreeIndex::TreeIndex(const BitMaze &maze) { build(maze); }
+
+template <class Maze> void TreeIndex::build(const Maze &maze) {
+  width_ = maze.width();
+  height_ = maze.height();
+  node.assign(width_ * height_, -1);
+
+  // Depth-first numbering: a cell is claimed (-2) when it is pushed, so it
+  // gets exactly one parent, and numbered when it is popped. Every subtree
+  // is popped before anything below it on the stack, which makes the
+  // numbers a preorder.
+  const int dx[4] = {1, -1, 0, 0};
+  const int dy[4] = {0, 0, 1, -1};
+  std::vector<std::pair<int, int> > stack; // (cell, parent node)
+  long links = 0;                          // pairs of adjacent open cells
+  int regions = 0;
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      if (maze(x, y) == WALL)
+        continue;
+      links += (maze(x + 1, y) != WALL) + (maze(x, y + 1) != WALL);
+      if (node[y * width_ + x] != -1)
+        continue;
+
+      ++regions;
+      node[y * width_ + x] = -2;
+      stack.push_back(std::make_pair(y * width_ + x, -1));
+      while (!stack.empty()) {
+        int cell = stack.back().first;
+        int from = stack.back().second;
+        stack.pop_back();
+        int id = cellOf.size();
+        node[cell] = id;
+        cellOf.push_back(cell);
+        parent.push_back(from);
+        depth.push_back(from < 0 ? 0 : depth[from] + 1);
+        region.push_back(from < 0 ? id : region[from]);
+
+        int cx = cell % width_;
+        int cy = cell / width_;
+        for (int d = 0; d < 4; ++d) {
+          int nx = cx + dx[d];
+          int ny = cy + dy[d];
+          // The maze's sentinel border reads as WALL past the edges
+          if (maze(nx, ny) == WALL || node[ny * width_ + nx] != -1)
+            continue;
+          node[ny * width_ + nx] = -2;
+          stack.push_back(std::make_pair(ny * width_ + nx, id));
+        }
+      }
+    }
+  }
+  // A forest of n nodes in r trees has exactly n - r links
+  tree = links == static_cast<long>(cellOf.size()) - regions;
+
+  int blocks = (cellOf.size() + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+  blockMin.assign(1, std::vector<int>(blocks));
+  for (int b = 0; b < blocks; ++b) {
+    int last = std::min<int>((b + 1) * BLOCK_SIZE, cellOf.size()) - 1;
+    int best = b * BLOCK_SIZE;
+    for (int n = best + 1; n <= last; ++n) {
+      if (depth[n] < depth[best])
+        best = n;
+    }
+    blockMin[0][b] = best;
+  }
+  for (int k = 1; (1 << k) <= blocks; ++k) {
+    const std::vector<int> &lower = blockMin[k - 1];
+    std::vector<int> level(blocks - (1 << k) + 1);
+    for (size_t b = 0; b < level.size(); ++b) {
+      int a = lower[b];
+      int c = lower[b + (1 << (k - 1))];
+      level[b] = depth[c] < depth[a] ? c : a;
+    }
+    blockMin.push_back(level);
+  }
+}
+
+int TreeIndex::nodeAt(int x, int y) const {
+  if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    return -1;
+  return node[y * width_ + x];
+}
+
+int TreeIndex::shallowest(int first, int last) const {
+  int firstBlock = first >> BLOCK_SHIFT;
+  int lastBlock = last >> BLOCK_SHIFT;
+  int best = first;
+  auto scan = [&](int from, int to) {
+    for (int n = from; n <= to; ++n) {
+      if (depth[n] < depth[best])
+        best = n;
+    }
+  };
+  if (lastBlock - firstBlock <= 1) {
+    scan(first, last);
+    return best;
+  }
+  scan(first, (firstBlock + 1) * BLOCK_SIZE - 1);
+  scan(lastBlock * BLOCK_SIZE, last);
+  // Two overlapping power-of-two spans cover the whole blocks in between
+  int from = firstBlock + 1;
+  int count = lastBlock - from;
+  int k = 0;
+  while ((2 << k) <= count)
+    ++k;
+  int a = blockMin[k][from];
+  int b = blockMin[k][lastBlock - (1 << k)];
+  if (depth[a] < depth[best])
+    best = a;
+  if (depth[b] < depth[best])
+    best = b;
+  return best;
+}
+
+// Function to find the lowest common ancestor of two nodes of one region.
+// With u numbered before v, the shallowest node numbered after u up to v
+// is the child of the ancestor on the way down to v.
+int TreeIndex::ancestor(int u, int v) const {
+  if (u == v)
+    return u;
+  if (u > v)
+    std::swap(u, v);
+  return parent[shallowest(u + 1, v)];
+}
+
+int TreeIndex::distance(int startX, int startY, int goalX, int goalY) const {
+  int u = nodeAt(startX, startY);
+  int v = nodeAt(goalX, goalY);
+  if (u < 0 || v < 0 || region[u] != region[v])
+    return -1;
+  return depth[u] + depth[v] - 2 * depth[ancestor(u, v)];
+}
+
+SearchResult TreeIndex::findPath(int startX, int startY, int goalX,
+                                 int goalY) const {
+  SearchResult result;
+  int u = nodeAt(startX, startY);
+  int v = nodeAt(goalX, goalY);
+  if (u < 0 || v < 0 || region[u] != region[v])
+    return result;
+
+  int top = ancestor(u, v);
+  std::vector<std::pair<int, int> > &path = result.path;
+  path.reserve(depth[u] + depth[v] - 2 * depth[top] + 1);
+  // Climb from start to the ancestor, then append the climb from goal
+  // reversed
+  for (int n = u; n != top; n = parent[n])
+    path.push_back(std::make_pair(cellOf[n] % width_, cellOf[n] / width_));
+  path.push_back(std::make_pair(cellOf[top] % width_, cellOf[top] / width_));
+  size_t down = path.size();
+  for (int n = v; n != top; n = parent[n])
+    path.push_back(std::make_pair(cellOf[n] % width_, cellOf[n] / width_));
+  std::reverse(path.begin() + down, path.end());
+  result.found = true;
+  return result;
+}
@@ -0,0 +1,58 @@
+#ifndef MAZE_TREEINDEX_H
+#define MAZE_TREEINDEX_H
+
+#include "bitmaze.h"
+#include "grid.h"
+#include "solver.h"
+#include <vector>
+
+// Path index for mazes without loops. In a perfect maze the open cells form a
+// tree, so the path between two cells is unique: it climbs from both ends to
+// their lowest common ancestor (LCA). The index roots every connected region
+// at its first cell in row order, numbers the cells in depth-first preorder
+// and keeps a range-minimum table over their depths. Given that, a distance
+// costs O(1) and a path O(path length), without searching.
+//
+// Mazes with loops are indexed through a spanning tree of each region. Paths
+// are then still valid but not always shortest; isTree() tells the two
+// cases apart. Like JumpTable, the index stays valid only as long as the
+// maze's walls do not change.
+class TreeIndex {
+public:
+  explicit TreeIndex(const Grid &maze);
+  explicit TreeIndex(const BitMaze &maze);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // Number of open cells
+  int nodeCount() const { return parent.size(); }
+  // Whether the open cells have no loops, i.e. all paths are shortest
+  bool isTree() const { return tree; }
+
+  // Function to return the number of steps between two cells, or -1 when
+  // either is a wall or they are not connected
+  int distance(int startX, int startY, int goalX, int goalY) const;
+  // Function to return the path between two cells, start and goal included;
+  // expanded stays 0 as nothing is searched
+  SearchResult findPath(int startX, int startY, int goalX, int goalY) const;
+
+private:
+  template <class Maze> void build(const Maze &maze);
+  // Node of a cell, -1 for walls and cells outside the maze
+  int nodeAt(int x, int y) const;
+  // Node of smallest depth among nodes first .. last
+  int shallowest(int first, int last) const;
+  int ancestor(int u, int v) const;
+
+  int width_, height_;
+  bool tree;
+  std::vector<int> node;   // node of every cell (y * width + x), -1 if wall
+  std::vector<int> cellOf; // y * width + x of every node
+  std::vector<int> parent; // -1 for the root of a region
+  std::vector<int> depth;  // steps to the root of the region
+  std::vector<int> region; // root node of the region
+  // blockMin[k][b] is the shallowest node of blocks b .. b + 2^k - 1
+  std::vector<std::vector<int> > blockMin;
+};
+
+#endif // MAZE_TREEINDEX_H
@@ -1,68 +1,79 @@
+#include "utils.h"
+#include "definitions.h"
+#include "grid.h"
+#include "mazefile.h"
+#include <cerrno>
 #include <chrono>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
 #include <thread>
 #include <string>
 #include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
-std::vector<std::vector<char> > loadMaze(const std::string &filename) {
-  std::vector<std::vector<char> > maze;
-  std::ifstream file(filename);
-  std::string line;
-
-  if (!file.is_open()) {
-    std::cerr << "Failed to open file: " << filename << std::endl;
-    return maze; // Returns an empty maze if file opening fails
-  }
-
-  while (std::getline(file, line)) {
-    std::vector<char> row;
-    for (char cell : line) {
-      row.push_back(cell);
-    }
-    maze.push_back(row);
+Grid loadMaze(const std::string &filename) {
+  if (isBinaryMaze(filename)) {
+    BitMaze maze = loadBinaryMaze(filename);
+    return maze.empty() ? Grid() : toGrid(maze);
   }
-
-  file.close();
-  return maze;
+  return loadTextMaze(filename);
 }
 
-void clearScreen() {
+bool writeOutput(const char *data, std::size_t size) {
+  std::cout.flush();
+  std::fflush(stdout);
 #ifdef _WIN32
-  system("CLS");
+  bool written = std::fwrite(data, 1, size, stdout) == size;
+  return std::fflush(stdout) == 0 && written;
 #else
-  system("clear");
+  // write() may accept only part of a large frame on pipes and terminals,
+  // and is interrupted by signals such as SIGWINCH on a resize
+  while (size > 0) {
+    ssize_t written = write(STDOUT_FILENO, data, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= written;
+  }
+  return true;
 #endif
 }
 
-void renderMaze(const std::vector<std::vector<char> > &maze, int delay,
-                bool pad, std::string message) {
-  clearScreen();
-  for (const auto &row : maze) {
-    for (char cell : row) {
-      if (pad) {
-        std::cout << cell << ' ';
-      } else {
-        std::cout << cell;
-      }
+void clearScreen() {
+  static const char sequence[] = "\x1b[H\x1b[2J";
+  writeOutput(sequence, sizeof(sequence) - 1);
+}
+
+void renderMaze(const Grid &maze, int delay, bool pad, std::string message) {
+  std::string frame = "\x1b[H\x1b[2J";
+  for (int y = 0; y < maze.height(); ++y) {
+    const char *row = maze.row(y);
+    for (int x = 0; x < maze.width(); ++x) {
+      frame.push_back(row[x]);
+      if (pad)
+        frame.push_back(' ');
     }
-    std::cout << '\n';
+    frame.push_back('\n');
   }
   if (!message.empty()) {
-    std::cout << message << std::endl;
+    frame += message;
+    frame.push_back('\n');
   }
+  writeOutput(frame.data(), frame.size());
   std::this_thread::sleep_for(
       std::chrono::milliseconds(delay)); // Slow down for visualization
 }
 
+
 // int main() {
-//   std::vector<std::vector<char> > maze = loadMaze("maze.txt");
-//   std::cout << maze.size() << " " << maze[0].size() << std::endl;
-//   for (const auto &row : maze) {
-//     std::cout << row.size() << " ";
-//     // for (char cell : row) {
-//     //   std::cout << cell << ' ';
-//     // }
+//   Grid maze = loadMaze("maze.txt");
+//   std::cout << maze.height() << " " << maze.width() << std::endl;
+//   for (int y = 0; y < maze.height(); ++y) {
+//     std::cout.write(maze.row(y), maze.width());
 //     std::cout << '\n';
 //   }
 
@@ -1,14 +1,21 @@
 #ifndef MAZE_UTILS_H
 #define MAZE_UTILS_H
 
+#include "grid.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 
-// Function to load a maze from a file
-std::vector<std::vector<char> > loadMaze(const std::string &filename);
+// Function to load a maze from a text or binary maze file (see mazefile.h);
+// returns an empty maze, after printing why, if the file cannot be read or
+// its rows differ in width
+Grid loadMaze(const std::string &filename);
 // Function to render a maze
-void renderMaze(const std::vector<std::vector<char> > &maze, int delay = 5,
+void renderMaze(const Grid &maze, int delay = 5,
                 bool pad = true, std::string message = "");
 // Function to clear the screen
 void clearScreen();
+// Function to write raw bytes to stdout in one go, after anything already
+// buffered in std::cout; false if only part of them could be written
+bool writeOutput(const char *data, std::size_t size);
 #endif // MAZE_UTILS_H